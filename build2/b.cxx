@@ -1535,7 +1535,25 @@ main (int argc, char* argv[])
          << "  task_queue_full        " << st.task_queue_full       << '\n'
          << '\n'
          << "  wait_queue_slots       " << st.wait_queue_slots      << '\n'
-         << "  wait_queue_collisions  " << st.wait_queue_collisions << '\n';
+         << "  wait_queue_collisions  " << st.wait_queue_collisions << '\n'
+         << '\n'
+         << "  headers_pregenerated   "
+         << stat_headers_pregenerated.load (memory_order_relaxed)  << '\n'
+         << '\n'
+         << "  object_bytes           "
+         << stat_object_bytes.load (memory_order_relaxed)          << '\n'
+         << "  link_msec              "
+         << stat_link_msec.load (memory_order_relaxed)             << '\n'
+         << '\n'
+         << "  pattern_tests          "
+         << stat_pattern_tests.load (memory_order_relaxed)         << '\n'
+         << "  pattern_matches        "
+         << stat_pattern_matches.load (memory_order_relaxed)       << '\n'
+         << '\n'
+         << "  buildfiles_replayed    "
+         << stat_buildfiles_replayed.load (memory_order_relaxed)   << '\n'
+         << "  buildfiles_lexed       "
+         << stat_buildfiles_lexed.load (memory_order_relaxed)      << '\n';
   }
 
   return r;
@@ -5,6 +5,7 @@
 #include <build2/bin/guess.hxx>
 
 #include <build2/diagnostics.hxx>
+#include <build2/probe-cache.hxx>
 
 using namespace std;
 
@@ -38,7 +39,10 @@ namespace build2
     }
 
     ar_info
-    guess_ar (const path& ar, const path* rl, const dir_path& fallback)
+    guess_ar (const path& ar,
+              const path* rl,
+              const dir_path& fallback,
+              const dir_path& out_root)
     {
       tracer trace ("bin::guess_ar");
 
@@ -69,6 +73,40 @@ namespace build2
         rlp = run_search (*rl, true, fallback, true /* path_only */);
       }
 
+      // See if we have the result cached (see probe-cache.hxx for details).
+      // Note that ranlib is part of the key as extra data.
+      //
+      const char* kind ("bin.ar-1");
+      string key;
+      {
+        string rk;
+        if (rl == nullptr ||
+            !(rk = probe_key (kind, rlp, {}, string ())).empty ())
+          key = probe_key (kind, arp, {}, rk);
+
+        if (optional<strings> d = probe_load (out_root, kind, key))
+        {
+          if (d->size () == 7)
+          {
+            strings& v (*d);
+
+            l4 ([&]{trace << "cached ar '" << v[1] << "'";});
+
+            return ar_info {
+              move (arp),
+              move (v[0]),
+              move (v[1]),
+              move (v[2]),
+              parse_version (v[3]),
+
+              move (rlp),
+              move (v[4]),
+              move (v[5]),
+              move (v[6])};
+          }
+        }
+      }
+
       // Binutils, LLVM, and FreeBSD ar/ranlib all recognize the --version
       // option. While Microsoft's lib.exe doesn't support --version, it only
       // issues a warning and exits with zero status, printing its usual
@@ -244,6 +282,11 @@ namespace build2
           fail << "unable to guess " << *rl << " signature";
       }
 
+      probe_save (out_root, kind, key,
+                  strings {arr.id, arr.signature, arr.checksum,
+                           arr.version.string (),
+                           rlr.id, rlr.signature, rlr.checksum});
+
       return ar_info {
         move (arp),
         move (arr.id),
@@ -258,7 +301,9 @@ namespace build2
     }
 
     ld_info
-    guess_ld (const path& ld, const dir_path& fallback)
+    guess_ld (const path& ld,
+              const dir_path& fallback,
+              const dir_path& out_root)
     {
       tracer trace ("bin::guess_ld");
 
@@ -278,6 +323,23 @@ namespace build2
         pp = run_search (ld, true, fallback, true /* path_only */);
       }
 
+      // See if we have the result cached (see probe-cache.hxx for details).
+      //
+      const char* kind ("bin.ld-1");
+      string key (probe_key (kind, pp, {}, string ()));
+
+      if (optional<strings> d = probe_load (out_root, kind, key))
+      {
+        if (d->size () == 3)
+        {
+          strings& v (*d);
+
+          l4 ([&]{trace << "cached ld '" << v[1] << "'";});
+
+          return ld_info {move (pp), move (v[0]), move (v[1]), move (v[2])};
+        }
+      }
+
       // Binutils ld recognizes the --version option. Microsoft's link.exe
       // doesn't support --version (nor any other way to get the version
       // without the error exit status) but it will still print its banner.
@@ -384,12 +446,124 @@ namespace build2
       if (r.empty ())
         fail << "unable to guess " << ld << " signature";
 
+      probe_save (out_root, kind, key,
+                  strings {r.id, r.signature, r.checksum});
+
       return ld_info {
         move (pp), move (r.id), move (r.signature), move (r.checksum)};
     }
 
+    // Run the driver with -fuse-ld=<kind> -Wl,--version and return the
+    // result if the linker responded with the expected signature.
+    //
+    static ld_kind_info
+    probe_ld_kind (const process_path& driver, const char* kind)
+    {
+      tracer trace ("bin::probe_ld_kind");
+
+      string fuse ("-fuse-ld=");
+      fuse += kind;
+
+      const char* args[] = {
+        driver.recall_string (), fuse.c_str (), "-Wl,--version", nullptr};
+
+      // The first line of the --version output, for example:
+      //
+      // mold 1.0.0 (compatible with GNU ld)
+      // LLD 13.0.0 (compatible with GNU linkers)
+      // GNU gold (GNU Binutils for Ubuntu 2.34) 1.16
+      // GNU ld (GNU Binutils for Ubuntu) 2.34
+      //
+      auto f = [kind] (string& l, bool) -> guess_result
+      {
+        string k (kind);
+
+        if ((k == "mold" && l.compare (0, 5, "mold ") == 0)    ||
+            (k == "lld"  && l.compare (0, 4, "LLD ") == 0)     ||
+            (k == "gold" && l.compare (0, 9, "GNU gold ") == 0) ||
+            (k == "bfd"  && l.compare (0, 7, "GNU ld ") == 0))
+          return guess_result (move (k), move (l), semantic_version ());
+
+        return guess_result ();
+      };
+
+      // Suppress all the errors since the linker may not be available (in
+      // which case the driver fails).
+      //
+      sha256 cs;
+      guess_result r (
+        run<guess_result> (3, driver, args, f, false, false, &cs));
+
+      if (r.empty ())
+      {
+        l4 ([&]{trace << kind << " is not usable via "
+                      << driver.recall_string ();});
+        return ld_kind_info ();
+      }
+
+      return ld_kind_info {move (r.id), move (r.signature), cs.string ()};
+    }
+
+    ld_kind_info
+    guess_ld_kind (const process_path& driver,
+                   const string& kind,
+                   const dir_path& out_root)
+    {
+      tracer trace ("bin::guess_ld_kind");
+
+      if (kind == "default")
+        return ld_kind_info ();
+
+      if (kind != "auto" &&
+          kind != "mold" && kind != "lld" && kind != "gold" && kind != "bfd")
+        fail << "invalid config.bin.ld.kind value '" << kind << "'" <<
+          info << "expected default, auto, mold, lld, gold, or bfd";
+
+      // See if we have the result cached (see probe-cache.hxx for details).
+      // Note that the requested kind is part of the key.
+      //
+      const char* ck ("bin.ld.kind-1");
+      string key (probe_key (ck, driver, {}, kind));
+
+      if (optional<strings> d = probe_load (out_root, ck, key))
+      {
+        if (d->size () == 3)
+        {
+          strings& v (*d);
+
+          l4 ([&]{trace << "cached ld kind '" << v[0] << "'";});
+
+          return ld_kind_info {move (v[0]), move (v[1]), move (v[2])};
+        }
+      }
+
+      ld_kind_info r;
+
+      if (kind == "auto")
+      {
+        // In the order of (typical) link speed.
+        //
+        for (const char* k: {"mold", "lld", "gold"})
+        {
+          if (!(r = probe_ld_kind (driver, k)).kind.empty ())
+            break;
+        }
+      }
+      else if ((r = probe_ld_kind (driver, kind.c_str ())).kind.empty ())
+        fail << "unable to use " << kind << " linker via "
+             << driver.recall_string () <<
+          info << "use config.bin.ld.kind to override";
+
+      probe_save (out_root, ck, key,
+                  strings {r.kind, r.signature, r.checksum});
+
+      return r;
+    }
+
     rc_info
-    guess_rc (const path& rc, const dir_path& fallback)
+    guess_rc (const path& rc,
+              const dir_path& fallback,
+              const dir_path& out_root)
     {
       tracer trace ("bin::guess_rc");
 
@@ -409,6 +583,23 @@ namespace build2
         pp = run_search (rc, true, fallback, true /* path_only */);
       }
 
+      // See if we have the result cached (see probe-cache.hxx for details).
+      //
+      const char* kind ("bin.rc-1");
+      string key (probe_key (kind, pp, {}, string ()));
+
+      if (optional<strings> d = probe_load (out_root, kind, key))
+      {
+        if (d->size () == 3)
+        {
+          strings& v (*d);
+
+          l4 ([&]{trace << "cached rc '" << v[1] << "'";});
+
+          return rc_info {move (pp), move (v[0]), move (v[1]), move (v[2])};
+        }
+      }
+
       // Binutils windres recognizes the --version option.
       //
       // Version extraction is a @@ TODO.
@@ -457,6 +648,9 @@ namespace build2
       if (r.empty ())
         fail << "unable to guess " << rc << " signature";
 
+      probe_save (out_root, kind, key,
+                  strings {r.id, r.signature, r.checksum});
+
       return rc_info {
         move (pp), move (r.id), move (r.signature), move (r.checksum)};
     }
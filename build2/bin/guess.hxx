@@ -45,8 +45,14 @@ namespace build2
     // The ranlib path can be NULL, in which case no ranlib guessing will be
     // attemplated and the returned ranlib_* members will be left empty.
     //
+    // The result is cached in the out_root's probe cache (see
+    // probe-cache.hxx for details). The same applies to the functions below.
+    //
     ar_info
-    guess_ar (const path& ar, const path* ranlib, const dir_path& fallback);
+    guess_ar (const path& ar,
+              const path* ranlib,
+              const dir_path& fallback,
+              const dir_path& out_root);
 
     // ld information.
     //
@@ -77,7 +83,37 @@ namespace build2
     };
 
     ld_info
-    guess_ld (const path& ld, const dir_path& fallback);
+    guess_ld (const path& ld,
+              const dir_path& fallback,
+              const dir_path& out_root);
+
+    // Linker selected via a GCC-compatible compiler driver (-fuse-ld=).
+    //
+    // The requested kind (config.bin.ld.kind) is one of the following:
+    //
+    // default      whatever the driver uses by default (no -fuse-ld=)
+    // auto         fastest available: mold, lld, gold, or default
+    // mold         mold
+    // lld          LLVM lld
+    // gold         GNU binutils ld.gold
+    // bfd          GNU binutils ld.bfd
+    //
+    // The linker is validated by running the driver with -Wl,--version and
+    // checking the output, which is also used to calculate the checksum. If
+    // the requested (non-auto) linker cannot be used, then this function
+    // fails. For default the kind, signature, and checksum are empty.
+    //
+    struct ld_kind_info
+    {
+      string kind;      // mold, lld, gold, bfd, or empty if default.
+      string signature;
+      string checksum;
+    };
+
+    ld_kind_info
+    guess_ld_kind (const process_path& driver,
+                   const string& kind,
+                   const dir_path& out_root);
 
     // rc information.
     //
@@ -101,7 +137,9 @@ namespace build2
     };
 
     rc_info
-    guess_rc (const path& rc, const dir_path& fallback);
+    guess_rc (const path& rc,
+              const dir_path& fallback,
+              const dir_path& out_root);
   }
 }
 
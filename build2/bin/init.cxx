@@ -66,6 +66,8 @@ namespace build2
       vp.insert<strings>   ("config.bin.liba.lib", true);
       vp.insert<strings>   ("config.bin.libs.lib", true);
       vp.insert<dir_paths> ("config.bin.rpath",    true);
+      vp.insert<string>    ("config.bin.ld.kind",  true);
+      vp.insert<bool>      ("config.bin.liba.thin", true);
 
       vp.insert<string>    ("config.bin.prefix", true);
       vp.insert<string>    ("config.bin.suffix", true);
@@ -74,11 +76,20 @@ namespace build2
       vp.insert<string>    ("config.bin.exe.prefix", true);
       vp.insert<string>    ("config.bin.exe.suffix", true);
 
-      vp.insert<string>    ("bin.lib");
-      vp.insert<strings>   ("bin.exe.lib");
-      vp.insert<strings>   ("bin.liba.lib");
-      vp.insert<strings>   ("bin.libs.lib");
-      vp.insert<dir_paths> ("bin.rpath");
+      // These are looked up on every library/executable target so give
+      // them fast slots (see variable_pool::insert_slot()).
+      //
+      vp.insert_slot<string>    ("bin.lib");
+      vp.insert_slot<strings>   ("bin.exe.lib");
+      vp.insert_slot<strings>   ("bin.liba.lib");
+      vp.insert_slot<strings>   ("bin.libs.lib");
+      vp.insert_slot<dir_paths> ("bin.rpath");
+
+      // Use thin archives for static libraries that are not installed (see
+      // the cc link rule for details). Utility libraries always use thin
+      // archives if supported.
+      //
+      vp.insert<bool>      ("bin.liba.thin");
 
       // Link whole archive. Note: non-overridable with target visibility.
       //
@@ -96,7 +107,7 @@ namespace build2
       //
       // If unspecified, defaults to false for liba{} and to true for libu*{}.
       //
-      vp.insert<bool>      ("bin.whole", false, variable_visibility::target);
+      vp.insert_slot<bool> ("bin.whole", variable_visibility::target);
 
       vp.insert<string>    ("bin.lib.prefix");
       vp.insert<string>    ("bin.lib.suffix");
@@ -183,6 +194,14 @@ namespace build2
           v = *required (rs, "config.bin.libs.lib", libs_lib).first;
       }
 
+      // config.bin.liba.thin
+      //
+      // This one is not used very often so we omit it from config.build if
+      // not specified.
+      //
+      if (lookup l = omitted (rs, "config.bin.liba.thin").first)
+        rs.assign ("bin.liba.thin") = *l;
+
       // config.bin.rpath
       //
       // This one is optional and we merge it into bin.rpath, if any.
@@ -584,7 +603,10 @@ namespace build2
         const path* ranlib (cast_null<path> (rp.first));
 
         ar_info ari (
-          guess_ar (ar, ranlib, fb ? dir_path (*pat) : dir_path ()));
+          guess_ar (ar,
+                    ranlib,
+                    fb ? dir_path (*pat) : dir_path (),
+                    rs.out_path ()));
 
         // If this is a new value (e.g., we are configuring), then print the
         // report at verbosity level 2 and up (-v).
@@ -727,7 +749,8 @@ namespace build2
             config::save_commented));
 
         const path& ld (cast<path> (p.first));
-        ld_info ldi (guess_ld (ld, fb ? dir_path (*pat) : dir_path ()));
+        ld_info ldi (
+          guess_ld (ld, fb ? dir_path (*pat) : dir_path (), rs.out_path ()));
 
         // If this is a new value (e.g., we are configuring), then print the
         // report at verbosity level 2 and up (-v).
@@ -838,7 +861,8 @@ namespace build2
             config::save_commented));
 
         const path& rc (cast<path> (p.first));
-        rc_info rci (guess_rc (rc, fb ? dir_path (*pat) : dir_path ()));
+        rc_info rci (
+          guess_rc (rc, fb ? dir_path (*pat) : dir_path (), rs.out_path ()));
 
         // If this is a new value (e.g., we are configuring), then print the
         // report at verbosity level 2 and up (-v).
@@ -173,20 +173,22 @@ namespace build2
         v.insert<dir_paths>    ("c.sys_lib_dirs"),
         v.insert<dir_paths>    ("c.sys_inc_dirs"),
 
-        v.insert<strings>      ("c.poptions"),
-        v.insert<strings>      ("c.coptions"),
-        v.insert<strings>      ("c.loptions"),
-        v.insert<strings>      ("c.libs"),
+        // Looked up on every target (see variable_pool::insert_slot()).
+        //
+        v.insert_slot<strings> ("c.poptions"),
+        v.insert_slot<strings> ("c.coptions"),
+        v.insert_slot<strings> ("c.loptions"),
+        v.insert_slot<strings> ("c.libs"),
 
         v["cc.poptions"],
         v["cc.coptions"],
         v["cc.loptions"],
         v["cc.libs"],
 
-        v.insert<strings>      ("c.export.poptions"),
-        v.insert<strings>      ("c.export.coptions"),
-        v.insert<strings>      ("c.export.loptions"),
-        v.insert<vector<name>> ("c.export.libs"),
+        v.insert_slot<strings>      ("c.export.poptions"),
+        v.insert_slot<strings>      ("c.export.coptions"),
+        v.insert_slot<strings>      ("c.export.loptions"),
+        v.insert_slot<vector<name>> ("c.export.libs"),
 
         v["cc.export.poptions"],
         v["cc.export.coptions"],
@@ -202,9 +204,18 @@ namespace build2
         v["cc.system"],
         v["cc.module_name"],
         v["cc.reprocess"],
+        v["cc.pregenerate"],
+        v["cc.batch"],
+        v["cc.bmi_cache"],
+        v["cc.split_dwarf"],
+        v["cc.compress_debug"],
+        v["cc.dwp"],
 
         v.insert<string>   ("c.preprocessed"), // See cxx.preprocessed.
+        v.insert<bool>     ("c.unity", true),       // See cxx.unity.
+        v.insert<uint64_t> ("c.unity.batch", true), // See cxx.unity.batch.
         nullptr,                               // No __symexport (no modules).
+        nullptr,                               // No header units (no modules).
 
         v.insert<string>   ("c.std", variable_visibility::project),
 
@@ -326,6 +337,8 @@ namespace build2
         cast<target_triplet> (rs[cm.x_target]),
 
         cm.tstd,
+        cm.tld,
+        cm.ld_checksum,
 
         false, // No C modules yet.
         false, // No __symexport support since no modules.
@@ -0,0 +1,182 @@
+// file      : build2/cc/bmi-cache.cxx -*- C++ -*-
+// copyright : Copyright (c) 2014-2019 Code Synthesis Ltd
+// license   : MIT; see accompanying LICENSE file
+
+#include <libbutl/process.mxx> // process::current_id()
+
+#include <build2/target.hxx>
+#include <build2/filesystem.hxx>
+#include <build2/diagnostics.hxx>
+
+#include <build2/cc/compile-rule.hxx>
+
+using namespace std;
+using namespace butl;
+
+namespace build2
+{
+  namespace cc
+  {
+    // The BMI cache allows sharing compiled module interfaces (both the BMI
+    // and the object file) between configurations, which is primarily
+    // useful for modules of installed libraries (std-like) that are
+    // otherwise rebuilt in the modules sidebuild of every configuration.
+    //
+    // The cache is a directory (cc.bmi_cache) with an entry subdirectory
+    // for each key that contains the bmi and obj files. The key is the
+    // checksum of the compiler, the compile (but not preprocessor) options,
+    // the target type, and the module interface translation unit (calculated
+    // in apply()) plus the contents of the BMIs that it imports (calculated
+    // here, after they have been updated). So a hit implies we would have
+    // compiled exactly the same thing. And since the key does not depend on
+    // the configuration's out tree, the entries are shared between them.
+    //
+    // The cache is best-effort: any errors are ignored and result in a miss
+    // (for load) or in the entry not being added (for save).
+    //
+    string compile_rule::
+    bmi_cache_key (action a,
+                   const file& t,
+                   const string& base,
+                   size_t start) const
+    {
+      sha256 cs;
+      cs.append (base);
+
+      if (start != 0)
+      {
+        const prerequisite_targets& pts (t.prerequisite_targets[a]);
+
+        for (size_t i (start); i != pts.size (); ++i)
+        {
+          const target* pt (pts[i]);
+          const file* f (pt != nullptr ? pt->is_a<file> () : nullptr);
+
+          if (f == nullptr)
+            continue;
+
+          try
+          {
+            ifdstream is (f->path (), fdopen_mode::binary, ifdstream::badbit);
+
+            char buf[8192];
+            do
+            {
+              is.read (buf, sizeof (buf));
+              cs.append (buf, static_cast<size_t> (is.gcount ()));
+            }
+            while (!is.eof ());
+          }
+          catch (const io_error&)
+          {
+            return string (); // Don't use the cache.
+          }
+        }
+      }
+
+      return cs.string ();
+    }
+
+    static inline dir_path
+    bmi_cache_entry (const dir_path& d, const string& k)
+    {
+      return d / dir_path (string (k, 0, 2)) / dir_path (k);
+    }
+
+    bool compile_rule::
+    bmi_cache_load (const dir_path& d,
+                    const string& k,
+                    const path& bmi,
+                    const path& obj) const
+    {
+      tracer trace (x, "compile_rule::bmi_cache_load");
+
+      if (k.empty ())
+        return false;
+
+      dir_path e (bmi_cache_entry (d, k));
+      path eb (e / path ("bmi"));
+      path eo (e / path ("obj"));
+
+      try
+      {
+        if (!file_exists (eb) || !file_exists (eo))
+          return false;
+
+        if (verb >= 2)
+        {
+          text << "cp " << eb << ' ' << bmi;
+          text << "cp " << eo << ' ' << obj;
+        }
+
+        cpfile (eb, bmi, cpflags::overwrite_content);
+        cpfile (eo, obj, cpflags::overwrite_content);
+
+        l5 ([&]{trace << "loaded " << e;});
+        return true;
+      }
+      catch (const system_error& ex)
+      {
+        l4 ([&]{trace << "unable to load " << e << ": " << ex;});
+      }
+
+      return false;
+    }
+
+    void compile_rule::
+    bmi_cache_save (const dir_path& d,
+                    const string& k,
+                    const path& bmi,
+                    const path& obj) const
+    {
+      tracer trace (x, "compile_rule::bmi_cache_save");
+
+      if (k.empty ())
+        return;
+
+      dir_path e (bmi_cache_entry (d, k));
+
+      // Populate a temporary directory next to the entry and then rename it
+      // into place so that concurrent users never see a partial entry. If
+      // someone beat us to it, then we simply discard ours.
+      //
+      dir_path te (
+        e.directory () /
+        dir_path (k + '.' + std::to_string (process::current_id ())));
+
+      try
+      {
+        if (dir_exists (e))
+          return;
+
+        if (verb >= 3)
+          text << "mkdir -p " << te;
+
+        try_mkdir_p (te);
+        cpfile (bmi, te / path ("bmi"), cpflags::overwrite_content);
+        cpfile (obj, te / path ("obj"), cpflags::overwrite_content);
+
+        try
+        {
+          mvfile (path (te.string ()), path (e.string ()));
+          l5 ([&]{trace << "saved " << e;});
+          return;
+        }
+        catch (const system_error&)
+        {
+          // Assume the entry already exists.
+        }
+      }
+      catch (const system_error& ex)
+      {
+        l4 ([&]{trace << "unable to save " << e << ": " << ex;});
+      }
+
+      try
+      {
+        butl::rmdir_r (te);
+      }
+      catch (const system_error&) {}
+    }
+  }
+}
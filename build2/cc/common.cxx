@@ -1016,5 +1016,77 @@ namespace build2
 
       return r;
     }
+
+    // Update the debug information state (initially r) according to the
+    // compile options and return the result. For the GCC class the last -g*
+    // option wins: -g0 disables debug information while any other, except
+    // the ones that only adjust the format (-gz*, -gno-*, -gsplit-dwarf),
+    // enables it. Note that we err on the side of caution by treating any
+    // unknown -g* option as enabling. For MSVC, /Z7, /Zi, and /ZI enable it.
+    //
+    bool common::
+    debug_info (bool r, const strings* os) const
+    {
+      if (os == nullptr)
+        return r;
+
+      for (const string& o: *os)
+      {
+        switch (cclass)
+        {
+        case compiler_class::gcc:
+          {
+            if (o.compare (0, 2, "-g") != 0    ||
+                o.compare (0, 3, "-gz") == 0   ||
+                o.compare (0, 5, "-gno-") == 0 ||
+                o == "-gsplit-dwarf")
+              continue;
+
+            r = (o != "-g0");
+            break;
+          }
+        case compiler_class::msvc:
+          {
+            if ((o[0] == '/' || o[0] == '-') &&
+                (o.compare (1, string::npos, "Z7") == 0 ||
+                 o.compare (1, string::npos, "Zi") == 0 ||
+                 o.compare (1, string::npos, "ZI") == 0))
+              r = true;
+
+            break;
+          }
+        }
+      }
+
+      return r;
+    }
+
+    bool common::
+    debug_info (const target& t) const
+    {
+      bool r (debug_info (false, cast_null<strings> (t[c_coptions])));
+      return debug_info (r, cast_null<strings> (t[x_coptions]));
+    }
+
+    // Split DWARF and compressed debug sections are only supported by GCC
+    // and Clang and only for ELF targets.
+    //
+    bool common::
+    split_dwarf (const target& t) const
+    {
+      return (ctype == compiler_type::gcc || ctype == compiler_type::clang) &&
+        (tclass == "linux" || tclass == "bsd")                              &&
+        cast_false<bool> (t[c_split_dwarf])                                 &&
+        debug_info (t);
+    }
+
+    bool common::
+    compress_debug (const target& t) const
+    {
+      return (ctype == compiler_type::gcc || ctype == compiler_type::clang) &&
+        (tclass == "linux" || tclass == "bsd")                              &&
+        cast_false<bool> (t[c_compress_debug])                              &&
+        debug_info (t);
+    }
   }
 }
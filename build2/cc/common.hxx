@@ -81,9 +81,18 @@ namespace build2
       const variable& c_system;       // cc.system
       const variable& c_module_name;  // cc.module_name
       const variable& c_reprocess;    // cc.reprocess
+      const variable& c_pregenerate;  // cc.pregenerate
+      const variable& c_batch;        // cc.batch
+      const variable& c_bmi_cache;    // cc.bmi_cache
+      const variable& c_split_dwarf;  // cc.split_dwarf
+      const variable& c_compress_debug; // cc.compress_debug
+      const variable& c_dwp;          // cc.dwp
 
       const variable& x_preprocessed; // x.preprocessed
+      const variable& x_unity;        // x.unity
+      const variable& x_unity_batch;  // x.unity.batch
       const variable* x_symexport;    // x.features.symexport
+      const variable* x_importable_headers; // x.importable_headers
 
       const variable& x_std;
 
@@ -134,6 +143,8 @@ namespace build2
       const string& tclass;         // x.target.class
 
       const strings& tstd;          // Translated x_std value (options).
+      const strings& tld;           // Linker selection option (-fuse-ld=).
+      const string& ld_checksum;    // Selected linker checksum, if any.
 
       bool modules;                 // x.features.modules
       bool symexport;               // x.features.symexport
@@ -184,6 +195,8 @@ namespace build2
             const process_path& path,
             const target_triplet& tgt,
             const strings& std,
+            const strings& ld,
+            const string& ldcs,
             bool fm,
             bool fs,
             const dir_paths& sld,
@@ -204,6 +217,7 @@ namespace build2
             cpath (path),
             ctgt (tgt), tsys (ctgt.system), tclass (ctgt.class_),
             tstd (std),
+            tld (ld), ld_checksum (ldcs),
             modules (fm),
             symexport (fs),
             sys_lib_dirs (sld), sys_inc_dirs (sid),
@@ -295,6 +309,21 @@ namespace build2
       dir_paths
       extract_library_dirs (const scope&) const;
 
+      // Debug information.
+      //
+    public:
+      bool
+      debug_info (bool, const strings*) const;
+
+      bool
+      debug_info (const target&) const;
+
+      bool
+      split_dwarf (const target&) const;
+
+      bool
+      compress_debug (const target&) const;
+
       // Alternative search logic for VC (msvc.cxx).
       //
       bin::liba*
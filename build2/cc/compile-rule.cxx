@@ -13,13 +13,14 @@
 #include <build2/context.hxx>
 #include <build2/variable.hxx>
 #include <build2/algorithm.hxx>
+#include <build2/filesystem.hxx>
 #include <build2/diagnostics.hxx>
 
 #include <build2/bin/target.hxx>
 #include <build2/config/utility.hxx> // create_project()
 
 #include <build2/cc/parser.hxx>
-#include <build2/cc/target.hxx>  // h
+#include <build2/cc/target.hxx>  // h, dwo
 #include <build2/cc/module.hxx>
 #include <build2/cc/utility.hxx>
 
@@ -46,11 +47,14 @@ namespace build2
     // 2. If an imported module is re-exported, then the module name is
     //    followed by '*'.
     //
+    // 3. An imported header unit name is enclosed in double quotes (since it
+    //    can contain spaces).
+    //
     // For example:
     //
     // foo! foo.core* foo.base* foo.impl
     // foo.base+ foo.impl
-    // foo.base foo.impl
+    // foo.base foo.impl "<vector>" "/usr/include/stdio.h"*
     //
     static string
     to_string (const module_info& m)
@@ -68,7 +72,14 @@ namespace build2
         if (!s.empty ())
           s += ' ';
 
-        s += i.name;
+        if (i.type == import_type::module_header)
+        {
+          s += '"';
+          s += i.name;
+          s += '"';
+        }
+        else
+          s += i.name;
 
         if (i.exported)
           s += '*';
@@ -84,6 +95,28 @@ namespace build2
 
       for (size_t b (0), e (0), n; (n = next_word (s, b, e, ' ')) != 0; )
       {
+        if (s[b] == '"')
+        {
+          // Header unit name that can contain spaces so find the closing
+          // quote and then re-position the word end.
+          //
+          size_t p (s.find ('"', b + 1));
+
+          if (p == string::npos)
+            break; // Corrupted, the caller will re-parse.
+
+          bool x (p + 1 != s.size () && s[p + 1] == '*');
+
+          m.imports.push_back (
+            module_import {import_type::module_header,
+                           string (s, b + 1, p - b - 1),
+                           x,
+                           0});
+
+          e = p + (x ? 2 : 1);
+          continue;
+        }
+
         char c (s[e - 1]);
         switch (c)
         {
@@ -101,7 +134,8 @@ namespace build2
           m.iface = (c == '!');
         }
         else
-          m.imports.push_back (module_import {move (w), c == '*', 0});
+          m.imports.push_back (
+            module_import {import_type::module_intf, move (w), c == '*', 0});
       }
 
       return m;
@@ -134,13 +168,21 @@ namespace build2
 
       translation_type type;
       preprocessed pp = preprocessed::none;
+      bool header = false;                   // Target is pch*{}.
       bool symexport = false;                // Target uses __symexport.
       bool touch = false;                    // Target needs to be touched.
+      bool split_dwarf = false;              // Produce .dwo (-gsplit-dwarf).
+      bool compress_debug = false;           // Compress debug sections (-gz).
       timestamp mt = timestamp_unknown;      // Target timestamp.
       prerequisite_member src;
       auto_rmfile psrc;                      // Preprocessed source, if any.
       path dd;                               // Dependency database path.
       module_positions mods = {0, 0, 0};
+      const file* pch = nullptr;             // Precompiled header, if used.
+      const file* pch_hdr = nullptr;         // Header to force-include.
+      batch* bat = nullptr;                  // Compilation batch, if any.
+      string bmi_key;                        // BMI cache key base, if any.
+      const header_units* hus = nullptr;     // Importable header units.
     };
 
     compile_rule::
@@ -156,6 +198,7 @@ namespace build2
     langopt (const match_data& md) const
     {
       bool m (md.type == translation_type::module_iface);
+      bool h (md.header || md.type == translation_type::module_header);
       //preprocessed p (md.pp);
 
       switch (ctype)
@@ -167,8 +210,8 @@ namespace build2
           //
           switch (x_lang)
           {
-          case lang::c:   return "c";
-          case lang::cxx: return "c++";
+          case lang::c:   return h ? "c-header" : "c";
+          case lang::cxx: return h ? "c++-header" : "c++";
           }
         }
         // Fall through.
@@ -181,8 +224,8 @@ namespace build2
           //
           switch (x_lang)
           {
-          case lang::c:   return "c";
-          case lang::cxx: return m ? "c++-module" : "c++";
+          case lang::c:   return h ? "c-header" : "c";
+          case lang::cxx: return h ? "c++-header" : m ? "c++-module" : "c++";
           }
         }
         // Fall through.
@@ -220,25 +263,100 @@ namespace build2
                       : "-D__symexport=");
     }
 
+    inline void compile_rule::
+    append_pch_options (cstrings& args,
+                        const match_data& md,
+                        string* s) const
+    {
+      // The PCH stands for its header so if we are not using it (including
+      // when preprocessing), we force-include the header itself.
+      //
+      if (md.pch_hdr == nullptr || !(md.pp < preprocessed::includes))
+        return;
+
+      if (s == nullptr || md.pch == nullptr)
+      {
+        args.push_back ("-include");
+        args.push_back (md.pch_hdr->path ().string ().c_str ());
+        return;
+      }
+
+      switch (ctype)
+      {
+      case compiler_type::gcc:
+        {
+          // GCC looks for <name>.gch before trying <name> itself so we pass
+          // the PCH path sans the extension.
+          //
+          *s = md.pch->path ().base ().string ();
+
+          args.push_back ("-include");
+          args.push_back (s->c_str ());
+          break;
+        }
+      case compiler_type::clang:
+        {
+          args.push_back ("-include-pch");
+          args.push_back (md.pch->path ().string ().c_str ());
+          break;
+        }
+      case compiler_type::msvc:
+      case compiler_type::icc:
+        assert (false);
+      }
+    }
+
+    // Find the header of a precompiled header target (the same logic as in
+    // match()).
+    //
+    const target* compile_rule::
+    search_pch_header (action a, const target& t) const
+    {
+      for (prerequisite_member p: reverse_group_prerequisite_members (a, t))
+      {
+        if (include (a, t, p) != include_type::normal)
+          continue;
+
+        if (p.is_a (**x_hdr))
+          return &p.search (t);
+      }
+
+      return nullptr;
+    }
+
     bool compile_rule::
     match (action a, target& t, const string&) const
     {
       tracer trace (x, "compile_rule::match");
 
       bool mod (t.is_a<bmix> ());
+      bool hdr (!mod && t.is_a<pchx> ());
 
-      // Link-up to our group (this is the obj/bmi{} target group protocol
-      // which means this can be done whether we match or not).
+      // Link-up to our group (this is the obj/bmi/pch{} target group
+      // protocol which means this can be done whether we match or not).
       //
       if (t.group == nullptr)
         t.group = &search (t,
-                           mod ? bmi::static_type : obj::static_type,
+                           (mod ? bmi::static_type :
+                            hdr ? pch::static_type : obj::static_type),
                            t.dir, t.out, t.name);
 
       // See if we have a source file. Iterate in reverse so that a source
       // file specified for a member overrides the one specified for the
       // group. Also "see through" groups.
       //
+      // For a precompiled header the "source" is the header and, to keep
+      // things unambiguous, we only recognize our primary header type (hxx{}
+      // for C++ and h{} for C).
+      //
+      // A bmi*{} without a module interface but with a header is a header
+      // unit (normally synthesized in the modules sidebuild; see
+      // importable_header_units()). Note that mxx{} is also a header so we
+      // only fall back to it if there is no module interface.
+      //
+      const prerequisite* hp (nullptr);
+      const target* hm (nullptr);
+
       for (prerequisite_member p: reverse_group_prerequisite_members (a, t))
       {
         // If excluded or ad hoc, then don't factor it into our tests.
@@ -246,38 +364,90 @@ namespace build2
         if (include (a, t, p) != include_type::normal)
           continue;
 
-        if (p.is_a (mod ? *x_mod : x_src))
+        if (p.is_a (mod ? *x_mod : hdr ? **x_hdr : x_src))
         {
           // Save in the target's auxiliary storage. Translation type will
           // be refined in apply().
           //
-          t.data (match_data (mod
-                              ? translation_type::module_iface
-                              : translation_type::plain,
-                              p));
+          match_data& md (
+            t.data (match_data (mod
+                                ? translation_type::module_iface
+                                : translation_type::plain,
+                                p)));
+          md.header = hdr;
           return true;
         }
+
+        if (mod && hp == nullptr && (x_header (p) || p.is_a<h> ()))
+        {
+          hp = &p.prerequisite;
+          hm = p.member;
+        }
+      }
+
+      if (hp != nullptr)
+      {
+        t.data (match_data (translation_type::module_header,
+                            prerequisite_member {*hp, hm}));
+        return true;
       }
 
       l4 ([&]{trace << "no " << x_lang << " source file for target " << t;});
       return false;
     }
 
-    // Append or hash library options from a pair of *.export.* variables
-    // (first one is cc.export.*) recursively, prerequisite libraries first.
+    bool compile_rule::lib_closure_key::
+    operator< (const lib_closure_key& y) const
+    {
+      if (base != y.base) return base < y.base;
+      if (lib != y.lib) return lib < y.lib;
+      if (type != y.type) return type < y.type;
+      if (order != y.order) return order < y.order;
+      if (inner != y.inner) return inner < y.inner;
+      return outer < y.outer;
+    }
+
+    // Return the interface closure of the specified library, computing and
+    // caching it if necessary. With deep library stacks recursively walking
+    // the *.export.libs graph for every translation unit (and several times
+    // for each, see below) becomes expensive while the result only depends
+    // on the library and is the same for all its dependents.
     //
-    void compile_rule::
-    append_lib_options (const scope& bs,
-                        cstrings& args,
-                        action a,
-                        const target& t,
-                        linfo li) const
+    // Note that similar to the prefix map cache the entries are never
+    // removed: the library state they are derived from (cc.type, export
+    // variables, prerequisite targets) is established when the library is
+    // matched, which has already happened by the time we are called.
+    //
+    auto compile_rule::
+    lib_closure (const scope& bs,
+                 action a,
+                 const file& l,
+                 bool la,
+                 linfo li) const -> const lib_closure_value&
     {
+      lib_closure_key k {
+        &bs, &l, li.type, li.order, a.inner_id, a.outer_id};
+
+      {
+        slock sl (lib_closure_mutex_);
+
+        auto i (lib_closures_.find (k));
+        if (i != lib_closures_.end ())
+          return i->second;
+      }
+
+      // Compute the closure without holding the lock since resolving
+      // imported libraries may need to search (and insert) targets. If
+      // several threads end up doing this at the same time, only the first
+      // gets to keep the result (which will be the same anyway).
+      //
+      lib_closure_value r;
+
       // See through utility libraries.
       //
       auto imp = [] (const file& l, bool la) {return la && l.is_a<libux> ();};
 
-      auto opt = [&args, this] (
+      auto opt = [&r, this] (
         const file& l, const string& t, bool com, bool exp)
       {
         // Note that in our model *.export.poptions are always "interface",
@@ -291,7 +461,10 @@ namespace build2
           ? c_export_poptions
           : (t == x ? x_export_poptions : var_pool[t + ".export.poptions"]));
 
-        append_options (args, l, var);
+        r.entries.push_back (lib_closure_entry {&l, &var});
+
+        if (const strings* v = cast_null<strings> (l[var]))
+          r.options.insert (r.options.end (), v->begin (), v->end ());
       };
 
       // In case we don't have the "small function object" optimization.
@@ -299,6 +472,25 @@ namespace build2
       const function<bool (const file&, bool)> impf (imp);
       const function<void (const file&, const string&, bool, bool)> optf (opt);
 
+      process_libraries (a, bs, li, sys_lib_dirs,
+                         l, la, 0, // Hack: lflags unused.
+                         impf, nullptr, optf);
+
+      ulock ul (lib_closure_mutex_);
+      return lib_closures_.emplace (move (k), move (r)).first->second;
+    }
+
+    // Call the specified function for the interface closure of each
+    // prerequisite library of the target.
+    //
+    template <typename F>
+    void compile_rule::
+    for_each_lib_closure (const scope& bs,
+                          action a,
+                          const target& t,
+                          linfo li,
+                          F&& f) const
+    {
       for (prerequisite_member p: group_prerequisite_members (a, t))
       {
         if (include (a, t, p) != include_type::normal) // Excluded/ad hoc.
@@ -317,13 +509,32 @@ namespace build2
                 pt->is_a<libs> ()))
             continue;
 
-          process_libraries (a, bs, li, sys_lib_dirs,
-                             pt->as<file> (), la, 0, // Hack: lflags unused.
-                             impf, nullptr, optf);
+          f (lib_closure (bs, a, pt->as<file> (), la, li));
         }
       }
     }
 
+    // Append or hash library options from a pair of *.export.* variables
+    // (first one is cc.export.*) recursively, prerequisite libraries first.
+    //
+    void compile_rule::
+    append_lib_options (const scope& bs,
+                        cstrings& args,
+                        action a,
+                        const target& t,
+                        linfo li) const
+    {
+      // Note that the cached options outlive the arguments.
+      //
+      for_each_lib_closure (
+        bs, a, t, li,
+        [&args] (const lib_closure_value& c)
+        {
+          for (const string& o: c.options)
+            args.push_back (o.c_str ());
+        });
+    }
+
     void compile_rule::
     hash_lib_options (const scope& bs,
                       sha256& cs,
@@ -331,48 +542,12 @@ namespace build2
                       const target& t,
                       linfo li) const
     {
-      auto imp = [] (const file& l, bool la) {return la && l.is_a<libux> ();};
-
-      auto opt = [&cs, this] (
-        const file& l, const string& t, bool com, bool exp)
-      {
-        if (!exp)
-          return;
-
-        const variable& var (
-          com
-          ? c_export_poptions
-          : (t == x ? x_export_poptions : var_pool[t + ".export.poptions"]));
-
-        hash_options (cs, l, var);
-      };
-
-      // The same logic as in append_lib_options().
-      //
-      const function<bool (const file&, bool)> impf (imp);
-      const function<void (const file&, const string&, bool, bool)> optf (opt);
-
-      for (prerequisite_member p: group_prerequisite_members (a, t))
-      {
-        if (include (a, t, p) != include_type::normal) // Excluded/ad hoc.
-          continue;
-
-        if (const target* pt = p.load ())
+      for_each_lib_closure (
+        bs, a, t, li,
+        [&cs] (const lib_closure_value& c)
         {
-          if (const libx* l = pt->is_a<libx> ())
-            pt = &link_member (*l, a, li);
-
-          bool la;
-          if (!((la = pt->is_a<liba> ())  ||
-                (la = pt->is_a<libux> ()) ||
-                pt->is_a<libs> ()))
-            continue;
-
-          process_libraries (a, bs, li, sys_lib_dirs,
-                             pt->as<file> (), la, 0, // Hack: lflags unused.
-                             impf, nullptr, optf);
-        }
-      }
+          hash_options (cs, c.options);
+        });
     }
 
     // Append library prefixes based on the *.export.poptions variables
@@ -385,48 +560,13 @@ namespace build2
                          target& t,
                          linfo li) const
     {
-      auto imp = [] (const file& l, bool la) {return la && l.is_a<libux> ();};
-
-      auto opt = [&m, this] (
-        const file& l, const string& t, bool com, bool exp)
-      {
-        if (!exp)
-          return;
-
-        const variable& var (
-          com
-          ? c_export_poptions
-          : (t == x ? x_export_poptions : var_pool[t + ".export.poptions"]));
-
-        append_prefixes (m, l, var);
-      };
-
-      // The same logic as in append_lib_options().
-      //
-      const function<bool (const file&, bool)> impf (imp);
-      const function<void (const file&, const string&, bool, bool)> optf (opt);
-
-      for (prerequisite_member p: group_prerequisite_members (a, t))
-      {
-        if (include (a, t, p) != include_type::normal) // Excluded/ad hoc.
-          continue;
-
-        if (const target* pt = p.load ())
+      for_each_lib_closure (
+        bs, a, t, li,
+        [&m, this] (const lib_closure_value& c)
         {
-          if (const libx* l = pt->is_a<libx> ())
-            pt = &link_member (*l, a, li);
-
-          bool la;
-          if (!((la = pt->is_a<liba> ())  ||
-                (la = pt->is_a<libux> ()) ||
-                pt->is_a<libs> ()))
-            continue;
-
-          process_libraries (a, bs, li, sys_lib_dirs,
-                             pt->as<file> (), la, 0, // Hack: lflags unused.
-                             impf, nullptr, optf);
-        }
-      }
+          for (const lib_closure_entry& e: c.entries)
+            append_prefixes (m, *e.lib, *e.var);
+        });
     }
 
     // Update the target during the match phase. Return true if it has changed
@@ -497,15 +637,17 @@ namespace build2
     {
       tracer trace (x, "compile_rule::apply");
 
-      file& t (xt.as<file> ()); // Either obj*{} or bmi*{}.
+      file& t (xt.as<file> ()); // Either obj*{}, bmi*{}, or pch*{}.
 
       match_data& md (t.data<match_data> ());
       bool mod (md.type == translation_type::module_iface);
+      bool hu (md.type == translation_type::module_header);
+      bool hdr (md.header);
 
       const scope& bs (t.base_scope ());
       const scope& rs (*bs.root_scope ());
 
-      otype ot (compile_type (t, mod));
+      otype ot (hdr ? pch_type (t) : compile_type (t, mod || hu));
       linfo li (link_info (bs, ot)); // Link info for selecting libraries.
       compile_target_types tt (compile_types (ot));
 
@@ -553,32 +695,41 @@ namespace build2
           }
         }
 
+        // Precompiled headers are only supported for GCC and Clang. MSVC
+        // would require a companion object file (/Yc) that must be linked
+        // into every binary that uses the PCH.
+        //
+        if (hdr && (ctype == compiler_type::msvc ||
+                    ctype == compiler_type::icc))
+          fail << "precompiled headers are not supported for " << ctype <<
+            info << "required by " << t;
+
         switch (ctype)
         {
         case compiler_type::gcc:
           {
-            e += mod ? "nms" : o;
+            e += mod || hu ? "nms" : hdr ? "gch" : o;
             break;
           }
         case compiler_type::clang:
           {
-            e += mod ? "pcm" : o;
+            e += mod || hu ? "pcm" : hdr ? "pch" : o;
             break;
           }
         case compiler_type::msvc:
           {
-            e += mod ? "ifc" : o;
+            e += mod || hu ? "ifc" : o;
             break;
           }
         case compiler_type::icc:
           {
-            assert (!mod);
+            assert (!mod && !hu);
             e += o;
           }
         }
 
         // If we are compiling a module, then the obj*{} is an ad hoc member
-        // of bmi*{}.
+        // of bmi*{}. A header unit has no object file.
         //
         if (mod)
         {
@@ -594,6 +745,34 @@ namespace build2
 
       const path& tp (t.derive_path (e.c_str ()));
 
+      // With split DWARF the compiler writes the debug information into the
+      // .dwo file next to the object file (named after it with the extension
+      // replaced) and we make it an ad hoc member so that it gets cleaned.
+      // For a module interface it is a member of bmi*{}, next to obj*{}.
+      //
+      if (!hdr && !hu)
+      {
+        if (split_dwarf (t))
+        {
+          const path& op (mod ? t.member->as<file> ().path () : tp);
+
+          target_lock dw (
+            add_adhoc_member (a,
+                              t,
+                              dwo::static_type,
+                              t.dir,
+                              t.out,
+                              op.base ().leaf ().string ()));
+
+          dw.target->as<file> ().derive_path ();
+          match_recipe (dw, group_recipe); // Set recipe and unlock.
+
+          md.split_dwarf = true;
+        }
+
+        md.compress_debug = compress_debug (t);
+      }
+
       // Inject dependency on the output directory.
       //
       const fsdir* dir (inject_fsdir (a, t));
@@ -663,6 +842,17 @@ namespace build2
         else if (pi == include_type::normal &&
                  (p.is_a<bmi> () || p.is_a (tt.bmi)))
           continue;
+        //
+        // If this is the pch{} group, then pick the member that matches our
+        // output type.
+        //
+        else if (pi == include_type::normal && p.is_a<pch> ())
+        {
+          pt = &search (t, tt.pch, p.key ());
+
+          if (a.operation () == clean_id && !pt->dir.sub (rs.out_path ()))
+            continue;
+        }
         else
         {
           pt = &p.search (t);
@@ -722,6 +912,66 @@ namespace build2
           md.symexport = l ? cast<bool> (l) : symexport;
         }
 
+        // If we have a precompiled header, then see if we can actually use
+        // it: it should be compiled for the same output type and with the
+        // same preprocessor (including from prerequisite libraries) and
+        // compile options (otherwise the compiler will reject it or, worse,
+        // the result will be inconsistent). If that's not the case, then we
+        // fall back to force-including its header, which is what the PCH
+        // stands for. Note that the output type check below also means the
+        // link info is the same for both.
+        //
+        if (!hdr && !hu)
+        {
+          auto ccs = [a, li, this] (const target& t) -> string
+          {
+            sha256 cs;
+            hash_options (cs, t.memoized (c_poptions));
+            hash_options (cs, t.memoized (x_poptions));
+            hash_lib_options (t.base_scope (), cs, a, t, li);
+            hash_options (cs, t.memoized (c_coptions));
+            hash_options (cs, t.memoized (x_coptions));
+            return cs.string ();
+          };
+
+          const target* pp (nullptr);
+          for (size_t i (start), n (pts.size ()); i != n; ++i)
+          {
+            const target* pt (pts[i]);
+
+            if (pt == nullptr || !pt->is_a<pchx> ())
+              continue;
+
+            if (pp != nullptr)
+              fail << "multiple precompiled headers for target " << t <<
+                info << "first is " << *pp <<
+                info << "second is " << *pt;
+
+            const target* h (search_pch_header (a, *pt));
+
+            if (h == nullptr)
+              fail << "no " << x_lang << " header for precompiled header "
+                   << *pt << " used by target " << t;
+
+            md.pch_hdr = &h->as<file> ();
+
+            if (pt->is_a (tt.pch) && ccs (*pt) == ccs (t))
+              md.pch = &pt->as<file> ();
+            else
+              l4 ([&]{trace << "incompatible precompiled header " << *pt
+                            << " for target " << t;});
+
+            pp = pt;
+          }
+        }
+
+        // If we have importable headers, then make sure their header units
+        // are built since they are needed to preprocess this translation
+        // unit (see importable_header_units() for details).
+        //
+        if (modules && !hdr && !hu && x_importable_headers != nullptr)
+          md.hus = importable_header_units (a, bs, t, tt);
+
         // Make sure the output directory exists.
         //
         // Is this the right thing to do? It does smell a bit, but then we do
@@ -770,6 +1020,7 @@ namespace build2
         // The idea is to keep them exactly as they are passed to the compiler
         // since the order may be significant.
         //
+        string ocs; // Also used as part of the compilation batch key.
         {
           sha256 cs;
 
@@ -781,8 +1032,8 @@ namespace build2
 
           if (md.pp != preprocessed::all)
           {
-            hash_options (cs, t, c_poptions);
-            hash_options (cs, t, x_poptions);
+            hash_options (cs, t.memoized (c_poptions));
+            hash_options (cs, t.memoized (x_poptions));
 
             // Hash *.export.poptions from prerequisite libraries.
             //
@@ -797,10 +1048,16 @@ namespace build2
               [] (const dir_path& d) {return d.string ();});
           }
 
-          hash_options (cs, t, c_coptions);
-          hash_options (cs, t, x_coptions);
+          hash_options (cs, t.memoized (c_coptions));
+          hash_options (cs, t.memoized (x_coptions));
           hash_options (cs, tstd);
 
+          if (md.split_dwarf)
+            cs.append ("-gsplit-dwarf");
+
+          if (md.compress_debug)
+            cs.append ("-gz");
+
           if (ot == otype::s)
           {
             // On Darwin, Win32 -fPIC is the default.
@@ -809,7 +1066,28 @@ namespace build2
               cs.append ("-fPIC");
           }
 
-          if (dd.expect (cs.string ()) != nullptr)
+          // The precompiled header (or its header if we cannot use it).
+          //
+          if (md.pch_hdr != nullptr)
+          {
+            cs.append (md.pch_hdr->path ().string ());
+
+            if (md.pch != nullptr)
+              cs.append (md.pch->path ().string ());
+          }
+
+          // The importable header units (changing the set changes which
+          // #include directives get translated).
+          //
+          if (md.hus != nullptr)
+          {
+            for (const header_unit& u: md.hus->units)
+              cs.append (u.header.string ());
+          }
+
+          ocs = cs.string ();
+
+          if (dd.expect (ocs) != nullptr)
             l4 ([&]{trace << "options mismatch forcing update of " << t;});
         }
 
@@ -879,6 +1157,14 @@ namespace build2
         // Store a translation unit's checksum to detect ignorable changes
         // (whitespaces, comments, etc).
         //
+        // Note that for a precompiled header we skip all of this: there are
+        // no modules to extract and the preprocessed token stream does not
+        // capture the macro definitions that end up in the PCH. The same
+        // reasoning applies to a header unit (we also don't support header
+        // units that import modules).
+        //
+        string tcs; // Translation unit checksum, if any.
+        if (!hdr && !hu)
         {
           optional<string> cs;
           if (string* l = dd.read ())
@@ -916,6 +1202,7 @@ namespace build2
               }
 
               tu = move (p.first);
+              cs = move (p.second);
             }
 
             if (modules)
@@ -944,6 +1231,9 @@ namespace build2
             break;
           }
 
+          if (cs)
+            tcs = move (*cs);
+
           // Make sure the translation unit type matches the resulting target
           // type.
           //
@@ -964,6 +1254,8 @@ namespace build2
                   info << "consider using " << x_mod->name << "{} instead";
               break;
             }
+          case translation_type::module_header:
+            assert (false);
           }
 
           md.type = tu.type ();
@@ -986,6 +1278,25 @@ namespace build2
               psrc.second = false;
           }
         }
+        else if (hu)
+        {
+          // The header unit name is its (absolute) header path. For GCC
+          // this is also the name in the module map that specifies the
+          // output BMI (see extract_modules() for the format).
+          //
+          string n (src.path ().string ());
+
+          if (ctype == compiler_type::gcc)
+          {
+            if (dd.expect ("@ " + n + ' ' + tp.string ()) != nullptr)
+              u = true;
+          }
+
+          if (value& v = t.state[a].assign (c_module_name))
+            assert (cast<string> (v) == n);
+          else
+            v = move (n);
+        }
 
         // If anything got updated, then we didn't rely on the cache. However,
         // the cached data could actually have been valid and the compiler run
@@ -1000,6 +1311,14 @@ namespace build2
         dd.close ();
         md.dd = move (dd.path);
 
+        // A precompiled header as well as a header unit must be compiled
+        // from the original header (again, because of macros). Similarly,
+        // the (partially) preprocessed output of a translation unit that uses
+        // a PCH has its header already expanded.
+        //
+        if (hdr || hu || md.pch_hdr != nullptr)
+          psrc.second = false;
+
         // If the preprocessed output is suitable for compilation, then pass
         // it along.
         //
@@ -1037,6 +1356,95 @@ namespace build2
         // second in depdb (which is never newer that the target).
         //
         md.mt = u ? timestamp_nonexistent : dd.mtime;
+
+        // If the BMI cache is enabled, then calculate the part of the cache
+        // key that we know at this stage (see bmi_cache_key() for details).
+        // The cache entry has no room for the split DWARF .dwo.
+        //
+        // Note that we cannot use the options checksum (ocs) here since it
+        // includes the preprocessor options (and thus the -I directories)
+        // which normally differ between configurations. But we don't need
+        // to: their effect is already captured by the translation unit
+        // checksum. For the same reason we don't use the cache if there is
+        // a precompiled header (its contents are not part of the TU).
+        //
+        if (u && mod && !md.split_dwarf && md.pch_hdr == nullptr &&
+            !tcs.empty ())
+        {
+          if (const dir_path* d =
+                cast_null<dir_path> (t.memoized (c_bmi_cache)))
+          {
+            if (!d->empty ())
+            {
+              sha256 cs;
+              cs.append (x);
+              cs.append (cast<string> (rs[x_checksum]));
+              cs.append (t.type ().name);
+
+              cs.append (&md.pp, sizeof (md.pp));
+              cs.append (&md.symexport, sizeof (md.symexport));
+
+              hash_options (cs, t.memoized (c_coptions));
+              hash_options (cs, t.memoized (x_coptions));
+              hash_options (cs, tstd);
+
+              if (md.compress_debug)
+                cs.append ("-gz");
+
+              if (ot == otype::s && (tclass == "linux" || tclass == "bsd"))
+                cs.append ("-fPIC");
+
+              if (md.hus != nullptr)
+              {
+                for (const header_unit& h: md.hus->units)
+                  cs.append (h.header.string ());
+              }
+
+              cs.append (tcs);
+              md.bmi_key = cs.string ();
+            }
+          }
+        }
+
+        // If batched compilation is enabled and we are definitely updating,
+        // then see if we can join a batch. Translation units that require
+        // per-target compiler options or outputs (modules, precompiled
+        // headers, split DWARF .dwo, VC's per-object .pdb) are always
+        // compiled individually.
+        //
+        if (u && !mod && !hu && !hdr && !md.split_dwarf &&
+            md.pch_hdr == nullptr && md.mods.start == 0)
+        {
+          lookup l (t.memoized (c_batch));
+
+          if (l && cast<uint64_t> (l) > 1 &&
+              (ctype == compiler_type::gcc   ||
+               ctype == compiler_type::clang ||
+               (ctype == compiler_type::msvc                          &&
+                !find_options ({"/Zi", "/ZI"}, t, c_coptions, true) &&
+                !find_options ({"/Zi", "/ZI"}, t, x_coptions, true))))
+          {
+            // The key is what must be the same for all the members of a
+            // batch: options (which include the compiler), output directory
+            // and type, and whether we compile (partially) preprocessed
+            // output.
+            //
+            string k (move (ocs));
+            k += '\n';
+            k += t.dir.string ();
+            k += '\n';
+            k += t.type ().name;
+            k += md.psrc.path.empty () ? "\ns" : "\np";
+
+            md.bat = batch_register (move (k),
+                                     cast<uint64_t> (l),
+                                     t,
+                                     (md.psrc.path.empty ()
+                                      ? src.path ()
+                                      : md.psrc.path),
+                                     md.dd);
+          }
+        }
       }
 
       switch (a)
@@ -1240,12 +1648,64 @@ namespace build2
       }
     }
 
+    bool compile_rule::prefix_key::
+    operator< (const prefix_key& y) const
+    {
+      if (base != y.base) return base < y.base;
+      if (c_poptions != y.c_poptions) return c_poptions < y.c_poptions;
+      if (x_poptions != y.x_poptions) return x_poptions < y.x_poptions;
+      if (type != y.type) return type < y.type;
+      if (order != y.order) return order < y.order;
+      if (libs != y.libs) return libs < y.libs;
+      return dir.compare (y.dir) < 0;
+    }
+
     auto compile_rule::
     build_prefix_map (const scope& bs,
                       action a,
                       target& t,
-                      linfo li) const -> prefix_map
+                      linfo li) const -> const prefix_map&
     {
+      // The map is determined by our own poptions values (and the target
+      // directory they are interpreted against) plus the set of prerequisite
+      // libraries (the rest is recursively determined by the libraries
+      // themselves). So we collect the libraries in the same way as
+      // append_lib_prefixes() and use all this as a cache key. Note that
+      // the (potentially expensive) recursive traversal is what we save.
+      //
+      prefix_key k {&bs,
+                    t.dir,
+                    t.memoized (c_poptions).value,
+                    t.memoized (x_poptions).value,
+                    li.type,
+                    li.order,
+                    vector<const target*> ()};
+
+      for (prerequisite_member p: group_prerequisite_members (a, t))
+      {
+        if (include (a, t, p) != include_type::normal) // Excluded/ad hoc.
+          continue;
+
+        if (const target* pt = p.load ())
+        {
+          if (const libx* l = pt->is_a<libx> ())
+            pt = &link_member (*l, a, li);
+
+          if (pt->is_a<liba> () || pt->is_a<libux> () || pt->is_a<libs> ())
+            k.libs.push_back (pt);
+        }
+      }
+
+      {
+        slock l (prefix_cache_mutex_);
+        auto i (prefix_cache_.find (k));
+        if (i != prefix_cache_.end ())
+          return i->second;
+      }
+
+      // Build the map without holding the lock. If another thread beats us
+      // to it, then we simply use its result.
+      //
       prefix_map m;
 
       // First process our own.
@@ -1257,7 +1717,186 @@ namespace build2
       //
       append_lib_prefixes (bs, m, a, t, li);
 
-      return m;
+      ulock l (prefix_cache_mutex_);
+      return prefix_cache_.emplace (move (k), move (m)).first->second;
+    }
+
+    // Update the generated headers that are declared as prerequisites of
+    // the libraries we depend on (recursively) and that will be generated
+    // in one of the prefix map directories.
+    //
+    // Without this every such header that we discover during extraction
+    // triggers an update followed by a restart of the preprocessor (since
+    // the updated header can, in turn, include other generated headers). For
+    // a translation unit that includes several generated headers this adds
+    // up. Instead we update all of them at once and in parallel. Return the
+    // number of headers that were changed by this update.
+    //
+    // Note that the matched headers are added to the target's prerequisite
+    // targets so that they are executed (and the dependency counts that
+    // match() incremented are decremented) as part of its update. If the
+    // header is later also discovered during extraction, then it is matched
+    // and added again, the same as any other header.
+    //
+    // Note that headers of the executable or library being built (as opposed
+    // to the ones we link) are not visible from here (they are prerequisites
+    // of the link target) and are still handled with restarts.
+    //
+    size_t compile_rule::
+    pregenerate_headers (action a,
+                         const scope& bs,
+                         file& t,
+                         linfo li,
+                         const prefix_map& pm) const
+    {
+      tracer trace (x, "compile_rule::pregenerate_headers");
+
+      if (pm.empty ())
+        return 0;
+
+      // Collect the libraries using the same traversal as in
+      // append_lib_prefixes().
+      //
+      small_vector<const file*, 16> ls;
+
+      auto imp = [] (const file& l, bool la) {return la && l.is_a<libux> ();};
+
+      auto opt = [&ls] (const file& l, const string&, bool, bool)
+      {
+        if (find (ls.begin (), ls.end (), &l) == ls.end ())
+          ls.push_back (&l);
+      };
+
+      const function<bool (const file&, bool)> impf (imp);
+      const function<void (const file&, const string&, bool, bool)> optf (opt);
+
+      for (prerequisite_member p: group_prerequisite_members (a, t))
+      {
+        if (include (a, t, p) != include_type::normal) // Excluded/ad hoc.
+          continue;
+
+        if (const target* pt = p.load ())
+        {
+          if (const libx* l = pt->is_a<libx> ())
+            pt = &link_member (*l, a, li);
+
+          bool la;
+          if (!((la = pt->is_a<liba> ())  ||
+                (la = pt->is_a<libux> ()) ||
+                pt->is_a<libs> ()))
+            continue;
+
+          process_libraries (a, bs, li, sys_lib_dirs,
+                             pt->as<file> (), la, 0, // Hack: lflags unused.
+                             impf, nullptr, optf);
+        }
+      }
+
+      // Now collect and match their headers that end up in one of the prefix
+      // map directories.
+      //
+      auto& pts (t.prerequisite_targets[a]);
+      size_t start (pts.size ());
+
+      vector<const target*> hs;
+
+      for (const file* l: ls)
+      {
+        // Skip libraries that don't belong to any project (e.g., imported
+        // as installed).
+        //
+        if (l->base_scope ().root_scope () == nullptr)
+          continue;
+
+        for (prerequisite_member p: group_prerequisite_members (a, *l))
+        {
+          if (include (a, *l, p) != include_type::normal ||
+              !(x_header (p) || p.is_a<h> ()))
+            continue;
+
+          const target& ht (p.search (*l));
+
+          auto i (find_if (pm.begin (), pm.end (),
+                           [&ht] (const prefix_map::value_type& v)
+                           {
+                             return ht.dir.sub (v.second.directory);
+                           }));
+
+          if (i == pm.end () ||
+              find_if (pts.begin () + start, pts.end (),
+                       [&ht] (const prerequisite_target& p)
+                       {
+                         return p.target == &ht;
+                       }) != pts.end ())
+            continue;
+
+          // Similar to update(), there is no need to execute the header if
+          // it is unchanged. We still need to add it to the prerequisite
+          // targets, however, since we've matched it.
+          //
+          target_state s (build2::match (a, ht));
+          pts.push_back (&ht);
+
+          if (s != target_state::unchanged)
+            hs.push_back (&ht);
+        }
+      }
+
+      if (hs.empty ())
+        return 0;
+
+      l6 ([&]{trace << "updating " << hs.size () << " headers for " << t;});
+
+      // Update in parallel. Similar to update() we only count a header if
+      // our execution actually caused it to change.
+      //
+      vector<target_state> os, ns (hs.size (), target_state::unknown);
+      for (const target* h: hs)
+        os.push_back (h->matched_state (a));
+
+      {
+        phase_switch ps (run_phase::execute);
+
+        atomic_count task_count (0);
+        wait_guard wg (task_count);
+
+        for (size_t i (0); i != hs.size (); ++i)
+        {
+          sched.async (task_count,
+                       [a] (const diag_frame* ds,
+                            const target& h,
+                            target_state& r)
+                       {
+                         diag_frame::stack_guard dsg (ds);
+
+                         try
+                         {
+                           r = execute_direct (a, h);
+                         }
+                         catch (const failed&)
+                         {
+                           r = target_state::failed;
+                         }
+                       },
+                       diag_frame::stack,
+                       cref (*hs[i]),
+                       ref (ns[i]));
+        }
+
+        wg.wait ();
+      }
+
+      size_t r (0);
+      for (size_t i (0); i != hs.size (); ++i)
+      {
+        if (ns[i] == target_state::failed)
+          throw failed (); // Diagnostics has already been issued.
+
+        if (ns[i] != os[i] && ns[i] != target_state::unchanged)
+          ++r;
+      }
+
+      return r;
     }
 
     // Return the next make prerequisite starting from the specified
@@ -1478,7 +2117,8 @@ namespace build2
 
       otype ot (li.type);
 
-      bool reprocess (cast_false<bool> (t[c_reprocess]));
+      bool reprocess (cast_false<bool> (t.memoized (c_reprocess)));
+      bool pregen (cast_false<bool> (t.memoized (c_pregenerate)));
 
       auto_rmfile psrc;
       bool puse (true);
@@ -1540,7 +2180,8 @@ namespace build2
       //
       environment env;
       cstrings args;
-      string out; // Storage.
+      string out;    // Storage.
+      strings hstor; // Header unit options storage.
 
       // Some compilers in certain modes (e.g., when also producing the
       // preprocessed output) are incapable of writing the dependecy
@@ -1691,7 +2332,7 @@ namespace build2
                         &src, &md, &psrc, &sense_diag,
                         &rs, &bs,
                         pp, &env, &args, &args_gen, &args_i, &out, &drm,
-                        &so_map, this]
+                        &hstor, &so_map, this]
         (bool& gen) -> const path*
       {
         const path* r (nullptr);
@@ -1746,8 +2387,8 @@ namespace build2
           //
           append_lib_options (bs, args, a, t, li);
 
-          append_options (args, t, c_poptions);
-          append_options (args, t, x_poptions);
+          append_options (args, t.memoized (c_poptions));
+          append_options (args, t.memoized (x_poptions));
 
           // Populate the src-out with the -I$out_base -I$src_base pairs.
           //
@@ -1879,6 +2520,9 @@ namespace build2
           if (md.symexport)
             append_symexport_options (args, t);
 
+          append_pch_options (args, md, nullptr);
+          append_header_units (args, hstor, md);
+
           // Some compile options (e.g., -std, -m) affect the preprocessor.
           //
           // Currently Clang supports importing "header modules" even when in
@@ -1900,8 +2544,8 @@ namespace build2
 
           bool clang (ctype == compiler_type::clang);
 
-          append_options (args, t, c_coptions, werror);
-          append_options (args, t, x_coptions, werror);
+          append_options (args, t.memoized (c_coptions), werror);
+          append_options (args, t.memoized (x_coptions), werror);
           append_options (args, tstd,
                           tstd.size () - (modules && clang ? 1 : 0));
 
@@ -2083,7 +2727,7 @@ namespace build2
       // Build the prefix map lazily only if we have non-existent files.
       // Also reuse it over restarts since it doesn't change.
       //
-      optional<prefix_map> pfx_map;
+      const prefix_map* pfx_map (nullptr);
 
       // If any prerequisites that we have extracted changed, then we have to
       // redo the whole thing. The reason for this is auto-generated headers:
@@ -2259,8 +2903,8 @@ namespace build2
           //
           if (f.normalized ())
           {
-            if (!pfx_map)
-              pfx_map = build_prefix_map (bs, a, t, li);
+            if (pfx_map == nullptr)
+              pfx_map = &build_prefix_map (bs, a, t, li);
 
             // First try the whole file. Then just the directory.
             //
@@ -2466,6 +3110,23 @@ namespace build2
         }
         else
         {
+          // Before running the compiler for the first time, update the
+          // generated headers that we can discover up front.
+          //
+          if (pregen)
+          {
+            pregen = false;
+
+            if (pfx_map == nullptr)
+              pfx_map = &build_prefix_map (bs, a, t, li);
+
+            if (size_t n = pregenerate_headers (a, bs, t, li, *pfx_map))
+            {
+              l5 ([&]{trace << "pregenerated " << n << " headers";});
+              stat_headers_pregenerated.fetch_add (n, memory_order_relaxed);
+            }
+          }
+
           try
           {
             if (force_gen)
@@ -2900,6 +3561,47 @@ namespace build2
       return make_pair (move (psrc), puse);
     }
 
+    // Return true if the compilation options enable instrumentation that
+    // makes the object file depend on the source line numbers (coverage,
+    // sanitizers) and r otherwise. Note that, unlike debug information (see
+    // common::debug_info()), such instrumentation cannot be disabled with
+    // -g0.
+    //
+    static bool
+    instrumented (compiler_class cc, bool r, const strings* os)
+    {
+      if (os != nullptr)
+      {
+        for (const string& o: *os)
+        {
+          switch (cc)
+          {
+          case compiler_class::gcc:
+            {
+              if (o == "--coverage"         ||
+                  o == "-ftest-coverage"    ||
+                  o == "-fprofile-arcs"     ||
+                  o == "-fcoverage-mapping" ||
+                  o.compare (0, 10, "-fsanitize") == 0)
+                r = true;
+
+              break;
+            }
+          case compiler_class::msvc:
+            {
+              if ((o[0] == '/' || o[0] == '-') &&
+                  o.compare (1, 9, "fsanitize") == 0)
+                r = true;
+
+              break;
+            }
+          }
+        }
+      }
+
+      return r;
+    }
+
     // Return the translation unit information (first) and its checksum
     // (second). If the checksum is empty, then it should not be used.
     //
@@ -2936,9 +3638,10 @@ namespace build2
       //
       environment env;
       cstrings args;
+      strings hstor;  // Header unit options storage.
       const path* sp; // Source path.
 
-      bool reprocess (cast_false<bool> (t[c_reprocess]));
+      bool reprocess (cast_false<bool> (t.memoized (c_reprocess)));
 
       bool ps; // True if extracting from psrc.
       if (md.pp < preprocessed::modules)
@@ -2966,8 +3669,8 @@ namespace build2
 
           append_lib_options (t.base_scope (), args, a, t, li);
 
-          append_options (args, t, c_poptions);
-          append_options (args, t, x_poptions);
+          append_options (args, t.memoized (c_poptions));
+          append_options (args, t.memoized (x_poptions));
 
           assert (sys_inc_dirs_extra <= sys_inc_dirs.size ());
           append_option_values (
@@ -2978,6 +3681,13 @@ namespace build2
           if (md.symexport)
             append_symexport_options (args, t);
 
+          // The (partially) preprocessed output already has the header.
+          //
+          if (!ps)
+            append_pch_options (args, md, nullptr);
+
+          append_header_units (args, hstor, md);
+
           // Make sure we don't fail because of warnings.
           //
           // @@ Can be both -WX and /WX.
@@ -2991,8 +3701,8 @@ namespace build2
 
           bool clang (ctype == compiler_type::clang);
 
-          append_options (args, t, c_coptions, werror);
-          append_options (args, t, x_coptions, werror);
+          append_options (args, t.memoized (c_coptions), werror);
+          append_options (args, t.memoized (x_coptions), werror);
           append_options (args, tstd,
                           tstd.size () - (modules && clang ? 1 : 0));
 
@@ -3061,6 +3771,19 @@ namespace build2
         sp = &src.path ();
       }
 
+      // Unless the object file depends on line numbers, don't include them
+      // into the checksum. This way changes like adding a line to a comment
+      // in a header don't cause recompilation.
+      //
+      bool lines;
+      {
+        const strings* cos (cast_null<strings> (t.memoized (c_coptions)));
+        const strings* xos (cast_null<strings> (t.memoized (x_coptions)));
+
+        lines = debug_info (debug_info (false, cos), xos) ||
+          instrumented (cclass, instrumented (cclass, false, cos), xos);
+      }
+
       // Preprocess and parse.
       //
       for (;;) // Breakout loop.
@@ -3102,7 +3825,7 @@ namespace build2
                         fdstream_mode::binary | fdstream_mode::skip);
 
           parser p;
-          translation_unit tu (p.parse (is, *sp));
+          translation_unit tu (p.parse (is, *sp, lines));
 
           is.close ();
 
@@ -3222,7 +3945,10 @@ namespace build2
       //
       if (!mi.iface && !mi.name.empty ())
         mi.imports.insert (mi.imports.begin (),
-                           module_import {move (mi.name), false, 0});
+                           module_import {import_type::module_intf,
+                                          move (mi.name),
+                                          false,
+                                          0});
 
       // The change to the set of imports would have required a change to
       // source code (or options). Changes to the bmi{}s themselves will be
@@ -3234,7 +3960,8 @@ namespace build2
       sha256 cs;
 
       if (!mi.imports.empty ())
-        md.mods = search_modules (a, bs, t, li, tt.bmi, src, mi.imports, cs);
+        md.mods = search_modules (a, bs, t, li, tt.bmi, src, mi.imports, cs,
+                                  md.hus);
 
       if (dd.expect (cs.string ()) != nullptr)
         updating = true;
@@ -3321,7 +4048,8 @@ namespace build2
                     const target_type& mtt,
                     const file& src,
                     module_imports& imports,
-                    sha256& cs) const
+                    sha256& cs,
+                    const header_units* hus) const
     {
       tracer trace (x, "compile_rule::search_modules");
 
@@ -3523,6 +4251,50 @@ namespace build2
       //
       bool done (false);
 
+      // Header unit imports can only be resolved to the importable headers'
+      // BMIs (see importable_header_units() for the reasons). We match the
+      // import name against both the name as specified in the importable
+      // headers list (<vector>) and its absolute path (which is what GCC
+      // writes into the preprocessed output). Once resolved, the import
+      // name becomes the header path, which is also the header unit's
+      // module name.
+      //
+      {
+        size_t r (0);
+        for (size_t i (0); i != n; ++i)
+        {
+          module_import& m (imports[i]);
+
+          if (m.type != import_type::module_header)
+            continue;
+
+          const header_unit* u (nullptr);
+          if (hus != nullptr)
+          {
+            for (const header_unit& hu: hus->units)
+            {
+              if (hu.name == m.name || hu.header.string () == m.name)
+              {
+                u = &hu;
+                break;
+              }
+            }
+          }
+
+          if (u == nullptr)
+            fail (relative (src)) << "header " << m.name << " is not "
+                                  << "importable" <<
+              info << "consider adding it to " << x << ".importable_headers";
+
+          pts[start + i] = u->bmi;
+          m.name = u->header.string ();
+          m.score = m.name.size () + 1;
+          ++r;
+        }
+
+        done = (r == n);
+      }
+
       auto check_fuzzy = [&trace, &imports, &pts, &match, start, n]
         (const target* pt, const string& name)
       {
@@ -3860,7 +4632,15 @@ namespace build2
               // score) but it's probably not worth it if we have a small
               // string optimization.
               //
-              imports.push_back (module_import {mn, true, 0});
+              imports.push_back (
+                module_import {
+                  (et->data<match_data> ().type ==
+                   translation_type::module_header
+                   ? import_type::module_header
+                   : import_type::module_intf),
+                  mn,
+                  true,
+                  0});
             }
           }
         }
@@ -3877,18 +4657,12 @@ namespace build2
       return module_positions {start, exported, copied};
     }
 
-    // Synthesize a dependency for building a module binary interface on
-    // the side.
+    // Return the modules sidebuild project directory creating and/or
+    // loading it if necessary.
     //
-    const target& compile_rule::
-    make_module_sidebuild (action a,
-                           const scope& bs,
-                           const target& lt,
-                           const target& mt,
-                           const string& mn) const
+    dir_path compile_rule::
+    modules_sidebuild (const scope& bs) const
     {
-      tracer trace (x, "compile_rule::make_module_sidebuild");
-
       // First figure out where we are going to build. We want to avoid
       // multiple sidebuilds so the outermost scope that has loaded the
       // cc.config module and that is within our amalgmantion seems like a
@@ -3982,6 +4756,23 @@ namespace build2
 #endif
       }
 
+      return pd;
+    }
+
+    // Synthesize a dependency for building a module binary interface on
+    // the side.
+    //
+    const target& compile_rule::
+    make_module_sidebuild (action a,
+                           const scope& bs,
+                           const target& lt,
+                           const target& mt,
+                           const string& mn) const
+    {
+      tracer trace (x, "compile_rule::make_module_sidebuild");
+
+      dir_path pd (modules_sidebuild (bs));
+
       // Next we need to come up with a file/target name that will be unique
       // enough not to conflict with other modules. If we assume that within
       // an amalgamation there is only one "version" of each module, then the
@@ -4070,6 +4861,23 @@ namespace build2
     void
     msvc_filter_cl (ifdstream&, const path& src);
 
+    // Return the size of the file or 0 if it cannot be determined (only used
+    // for statistics).
+    //
+    static uint64_t
+    output_size (const path& f)
+    {
+      try
+      {
+        pair<bool, entry_stat> pe (path_entry (f, true /* follow_symlinks */));
+        return pe.first ? pe.second.size : 0;
+      }
+      catch (const system_error&)
+      {
+        return 0;
+      }
+    }
+
     void compile_rule::
     append_modules (environment& env,
                     cstrings& args,
@@ -4089,7 +4897,9 @@ namespace build2
           //
           // Note that it is also used to specify the output BMI file.
           //
-          if (ms.start != 0 || md.type == translation_type::module_iface)
+          if (ms.start != 0                                ||
+              md.type == translation_type::module_iface    ||
+              md.type == translation_type::module_header)
           {
             string s (relative (md.dd).string ());
             s.insert (0, "-fmodule-mapper=");
@@ -4146,9 +4956,11 @@ namespace build2
             string s (relative (f.path ()).string ());
 
             // In Clang the module implementation's unit .pcm is special and
-            // must be "loaded".
+            // must be "loaded". As are header units, which have no name.
             //
-            if (md.type == translation_type::module_impl && i == ms.start)
+            if ((md.type == translation_type::module_impl && i == ms.start) ||
+                pt->data<match_data> ().type ==
+                translation_type::module_header)
               s.insert (0, "-fmodule-file=");
             else
             {
@@ -4181,12 +4993,22 @@ namespace build2
             // of these are bmi's.
             //
             const file& f (pt->as<file> ());
+            const string& mn (cast<string> (f.state[a].vars[c_module_name]));
 
+            // Header units are referenced by the header path.
+            //
+            if (pt->data<match_data> ().type ==
+                translation_type::module_header)
+            {
+              stor.push_back ("/headerUnit");
+              stor.push_back (mn + '=' + relative (f.path ()).string ());
+            }
+            //
             // In VC std.* modules can only come from a single directory
             // specified with the IFCPATH environment variable or the
             // /module:stdIfcDir option.
             //
-            if (std_module (cast<string> (f.state[a].vars[c_module_name])))
+            else if (std_module (mn))
             {
               dir_path d (f.path ().directory ());
 
@@ -4228,6 +5050,262 @@ namespace build2
         env.push_back ("IFCPATH");
     }
 
+    // Batched compilation.
+    //
+    // Starting a compiler process for every translation unit can be a
+    // significant overhead compared to the actual work, especially for C and
+    // with VC. So, if requested with cc.batch, translation units that are
+    // compiled with identical options into the same output directory are
+    // grouped into batches (of up to cc.batch members) at match time and each
+    // batch is compiled with a single compiler invocation.
+    //
+    // Only translation units that we know for sure need updating join a
+    // batch. Since all their inputs (sources, headers) are updated during
+    // match, the first member that gets executed (the leader) compiles the
+    // entire batch and the rest only pick up the result. The leader runs the
+    // compiler in a temporary subdirectory (next to its target) where the
+    // compiler writes the object files named after the sources (there is no
+    // way to specify the output file for each source). These are then moved
+    // into place.
+    //
+    // The compiler diagnostics (which is normally attributed by the compiler
+    // to the source file) is buffered and, if the batch compilation
+    // succeeded, printed. Otherwise it is discarded and each member falls
+    // back to compiling individually, which results in the diagnostics being
+    // attributed to the target that caused it.
+    //
+    // Note also that since the batch is compiled from a different working
+    // directory, any relative paths in the compile options will not work
+    // (though normally we only have absolute ones).
+    //
+    auto compile_rule::
+    batch_register (string k,
+                    uint64_t n,
+                    const file& t,
+                    const path& src,
+                    const path& dd) const -> batch*
+    {
+      mlock l (batch_mutex_);
+
+      batch*& b (batch_map_[move (k)]);
+
+      // Start a new batch if there is no open batch for this key or if it
+      // is full or has already been compiled (which can happen if some
+      // targets were updated during match).
+      //
+      if (b == nullptr                              ||
+          b->members.size () >= b->size              ||
+          b->state.load (memory_order_relaxed) != 2)
+      {
+        batches_.push_back (unique_ptr<batch> (new batch));
+        b = batches_.back ().get ();
+        b->size = n;
+      }
+
+      b->members.push_back (batch::member {&t, src, dd, false});
+      return b;
+    }
+
+    optional<timestamp> compile_rule::
+    batch_compile (batch& b,
+                   const file& t,
+                   const cstrings& args,
+                   size_t out_i,
+                   size_t out_n,
+                   const environment& env) const
+    {
+      tracer trace (x, "compile_rule::batch_compile");
+
+      // A batch of one is the same as individual compilation.
+      //
+      if (b.members.size () < 2)
+        return nullopt;
+
+      size_t s (2);
+      if (b.state.compare_exchange_strong (s, 1,
+                                           memory_order_acq_rel,
+                                           memory_order_acquire))
+      {
+        // We are the leader.
+        //
+        b.start = depdb::mtime_check ()
+          ? system_clock::now ()
+          : timestamp_unknown;
+
+        const char* oe (cclass == compiler_class::msvc ? ".obj" : ".o");
+        dir_path d (t.path () + ".batch");
+
+        // Figure out the object file names that the compiler will produce.
+        // If two members end up with the same name, then the second one is
+        // compiled individually.
+        //
+        vector<pair<batch::member*, path>> ms;
+        for (batch::member& m: b.members)
+        {
+          path o (m.src.leaf ().base () + oe);
+
+          if (find_if (ms.begin (), ms.end (),
+                       [&o] (const pair<batch::member*, path>& p)
+                       {
+                         return p.second == o;
+                       }) == ms.end ())
+            ms.emplace_back (&m, move (o));
+        }
+
+        try
+        {
+          if (ms.size () > 1)
+          {
+            // The depdb files must be no newer than the targets (see
+            // perform_update() for details).
+            //
+            for (const auto& p: ms)
+              touch (p.first->dd, false, verb_never);
+
+            mkdir_p (d, 3);
+
+            // The command line is the same as for the leader except for the
+            // output option(s) and the source (relied on being last).
+            //
+            // For VC we specify the output directory with /Fo (in the same
+            // form as the leader). For others we omit -o and rely on the
+            // working directory.
+            //
+            string fo;
+            cstrings bargs (args.begin (), args.begin () + out_i);
+
+            if (cclass == compiler_class::msvc)
+            {
+              if (out_n == 2)
+              {
+                fo = d.representation ();
+                bargs.push_back ("/Fo:");
+              }
+              else
+                fo = "/Fo" + d.representation ();
+
+              bargs.push_back (fo.c_str ());
+            }
+
+            bargs.insert (bargs.end (),
+                          args.begin () + out_i + out_n,
+                          args.end () - 2);            // Source, NULL.
+
+            for (const auto& p: ms)
+              bargs.push_back (p.first->src.string ().c_str ());
+
+            bargs.push_back (nullptr);
+
+            if (verb >= 3)
+              print_process (bargs);
+
+            l5 ([&]{trace << "compiling batch of " << ms.size () << " for "
+                          << t;});
+
+            // Merge STDERR into STDOUT (see perform_update() for why) and
+            // buffer all of it.
+            //
+            string diag;
+            bool r;
+            {
+              process pr (cpath,
+                          bargs.data (),
+                          0, -1, 1,
+                          d.string ().c_str (),
+                          env.empty () ? nullptr : env.data ());
+
+              try
+              {
+                ifdstream is (
+                  move (pr.in_ofd), fdstream_mode::text, ifdstream::badbit);
+
+                for (string l; !eof (getline (is, l)); )
+                {
+                  // VC prints the name of each source it compiles.
+                  //
+                  if (cclass == compiler_class::msvc &&
+                      find_if (ms.begin (), ms.end (),
+                               [&l] (const pair<batch::member*, path>& p)
+                               {
+                                 return l == p.first->src.leaf ().string ();
+                               }) != ms.end ())
+                    continue;
+
+                  diag += l;
+                  diag += '\n';
+                }
+
+                is.close ();
+              }
+              catch (const io_error&) {} // Assume exits with error.
+
+              r = run_finish (bargs.data (), pr, false);
+            }
+
+            b.mtime = system_clock::now ();
+
+            if (r)
+            {
+              for (const auto& p: ms)
+              {
+                const path& tp (p.first->target->path ());
+
+                try
+                {
+                  mvfile (d / p.second, tp);
+                }
+                catch (const system_error& e)
+                {
+                  fail << "unable to move " << d / p.second << " to " << tp
+                       << ": " << e;
+                }
+
+                p.first->done = true;
+              }
+
+              if (!diag.empty ())
+                diag_stream_lock () << diag;
+            }
+            else
+              l4 ([&]{trace << "batch compilation failed for " << t
+                            << ", compiling individually";});
+
+            rmdir_r (d, true, 3);
+          }
+        }
+        catch (const process_error& e)
+        {
+          error << "unable to execute " << args[0] << ": " << e;
+
+          if (e.child)
+            exit (1);
+        }
+        catch (const failed&)
+        {
+          // Diagnostics has already been issued. Members will try to compile
+          // individually.
+        }
+
+        b.state.store (0, memory_order_release);
+        sched.resume (b.state);
+      }
+      else if (s != 0)
+        sched.wait (0, b.state, scheduler::work_none);
+
+      for (const batch::member& m: b.members)
+      {
+        if (m.target == &t)
+        {
+          if (m.done)
+            return b.mtime;
+
+          break;
+        }
+      }
+
+      return nullopt;
+    }
+
     target_state compile_rule::
     perform_update (action a, const target& xt) const
     {
@@ -4236,6 +5314,8 @@ namespace build2
 
       match_data md (move (t.data<match_data> ()));
       bool mod (md.type == translation_type::module_iface);
+      bool hu (md.type == translation_type::module_header);
+      bool hdr (md.header);
 
       // While all our prerequisites are already up-to-date, we still have to
       // execute them to keep the dependency counts straight. Actually, no, we
@@ -4243,7 +5323,7 @@ namespace build2
       //
       auto pr (
         execute_prerequisites<file> (
-          (mod ? *x_mod : x_src),
+          (mod ? *x_mod : hdr ? **x_hdr : hu ? md.src.type () : x_src),
           a, t,
           md.mt,
           [s = md.mods.start] (const target&, size_t i)
@@ -4275,19 +5355,47 @@ namespace build2
                        ? system_clock::now ()
                        : timestamp_unknown);
 
-      touch (md.dd, false, verb_never);
-
       const scope& bs (t.base_scope ());
       const scope& rs (*bs.root_scope ());
 
-      otype ot (compile_type (t, mod));
+      otype ot (hdr ? pch_type (t) : compile_type (t, mod || hu));
       linfo li (link_info (bs, ot));
 
+      // If this module interface can be cached, then first see if it is
+      // already in the BMI cache. Note that we can only calculate the final
+      // key now that the imported BMIs have been updated.
+      //
+      const dir_path* bcd (nullptr);
+      string bck;
+
+      if (!md.bmi_key.empty ())
+      {
+        bcd = &cast<dir_path> (t.memoized (c_bmi_cache));
+        bck = bmi_cache_key (a, t, md.bmi_key, md.mods.start);
+
+        if (!bck.empty ())
+        {
+          touch (md.dd, false, verb_never);
+
+          if (bmi_cache_load (*bcd, bck, tp, t.member->as<file> ().path ()))
+          {
+            if (verb == 1)
+              text << x_name << ' ' << s;
+
+            timestamp now (system_clock::now ());
+            depdb::check_mtime (start, md.dd, tp, now);
+
+            t.mtime (now);
+            return target_state::changed;
+          }
+        }
+      }
+
       environment env;
       cstrings args {cpath.recall_string ()};
 
       // If we are building a module, then the target is bmi*{} and its ad hoc
-      // member is obj*{}.
+      // member is obj*{}. A header unit has no object file.
       //
       path relm;
       path relo (relative (mod ? t.member->is_a<file> ()->path () : tp));
@@ -4296,8 +5404,8 @@ namespace build2
       //
       if (md.pp != preprocessed::all)
       {
-        append_options (args, t, c_poptions);
-        append_options (args, t, x_poptions);
+        append_options (args, t.memoized (c_poptions));
+        append_options (args, t.memoized (x_poptions));
 
         // Add *.export.poptions from prerequisite libraries.
         //
@@ -4315,13 +5423,21 @@ namespace build2
           append_symexport_options (args, t);
       }
 
-      append_options (args, t, c_coptions);
-      append_options (args, t, x_coptions);
+      append_options (args, t.memoized (c_coptions));
+      append_options (args, t.memoized (x_coptions));
       append_options (args, tstd);
 
+      if (md.split_dwarf)
+        args.push_back ("-gsplit-dwarf");
+
+      if (md.compress_debug)
+        args.push_back ("-gz");
+
       string out, out1; // Output options storage.
       strings mods;     // Module options storage.
+      string pchs;      // Precompiled header options storage.
       size_t out_i (0); // Index of the -o option.
+      size_t out_n (0); // Number of output option arguments.
 
       if (cclass == compiler_class::msvc)
       {
@@ -4399,7 +5515,18 @@ namespace build2
           args.push_back (out1.c_str ());
         }
 
-        if (ver >= 18)
+        out_i = args.size ();
+
+        if (hu)
+        {
+          relm = relative (tp);
+
+          args.push_back ("/exportHeader");
+          args.push_back ("/ifcOnly");
+          args.push_back ("/ifcOutput");
+          args.push_back (relm.string ().c_str ());
+        }
+        else if (ver >= 18)
         {
           args.push_back ("/Fo:");
           args.push_back (relo.string ().c_str ());
@@ -4410,6 +5537,8 @@ namespace build2
           args.push_back (out.c_str ());
         }
 
+        out_n = args.size () - out_i;
+
         if (mod)
         {
           relm = relative (tp);
@@ -4437,21 +5566,32 @@ namespace build2
 
         append_modules (env, args, mods, a, t, md);
 
+        // Note that we never compile the (partially) preprocessed output if
+        // using a precompiled header (see apply()).
+        //
+        append_pch_options (args, md, &pchs);
+
         // Note: the order of the following options is relied upon below.
         //
         out_i = args.size (); // Index of the -o option.
 
-        if (mod)
+        if (mod || hu)
         {
           switch (ctype)
           {
           case compiler_type::gcc:
             {
               // Output module file is specified in the mapping file, the
-              // same as input.
+              // same as input. There is no object file for a header unit.
               //
-              args.push_back ("-o");
-              args.push_back (relo.string ().c_str ());
+              if (hu)
+                args.push_back ("-fmodule-header");
+              else
+              {
+                args.push_back ("-o");
+                args.push_back (relo.string ().c_str ());
+              }
+
               args.push_back ("-c");
               break;
             }
@@ -4459,6 +5599,9 @@ namespace build2
             {
               relm = relative (tp);
 
+              if (hu)
+                args.push_back ("-fmodule-header");
+
               args.push_back ("-o");
               args.push_back (relm.string ().c_str ());
               args.push_back ("--precompile");
@@ -4482,6 +5625,7 @@ namespace build2
           args.push_back ("-o");
           args.push_back (relo.string ().c_str ());
           args.push_back ("-c");
+          out_n = 2;
         }
 
         args.push_back ("-x");
@@ -4588,6 +5732,44 @@ namespace build2
           md.psrc.active = false;
       }
 
+      // If we are part of a batch, then try to compile it (or see if it has
+      // already been compiled by another member). If we were not compiled
+      // as part of the batch, then we fall back to compiling individually
+      // (which will also produce diagnostics that is attributed to us).
+      //
+      if (md.bat != nullptr)
+      {
+        if (optional<timestamp> mt =
+            batch_compile (*md.bat, t, args, out_i, out_n, env))
+        {
+          if (pact && verb >= 3)
+            md.psrc.active = true;
+
+          depdb::check_mtime (md.bat->start, md.dd, tp, *mt);
+
+          t.mtime (*mt);
+          return target_state::changed;
+        }
+      }
+
+      touch (md.dd, false, verb_never);
+
+      // Pass the options in a response file if the command line is too long
+      // (see the link rule for details). Note that in this case we keep the
+      // original arguments since we may need to adjust them for the second
+      // Clang invocation below.
+      //
+      auto_rmfile trm;
+      string targ;
+      cstrings oargs;
+      rspfile (args,
+               1,
+               tp + ".t", // Use the .t extension (for "temporary").
+               cclass == compiler_class::msvc,
+               trm,
+               targ,
+               &oargs);
+
       if (verb >= 3)
         print_process (args);
 
@@ -4638,7 +5820,10 @@ namespace build2
         error << "unable to execute " << args[0] << ": " << e;
 
         if (e.child)
+        {
+          trm.cancel ();
           exit (1);
+        }
 
         throw failed ();
       }
@@ -4659,6 +5844,9 @@ namespace build2
         // Adjust the command line. First discard everything after -o then
         // build the new "tail".
         //
+        if (!targ.empty ())
+          args = move (oargs);
+
         args.resize (out_i + 1);
         args.push_back (relo.string ().c_str ()); // Produce .o.
         args.push_back ("-c");                    // By compiling .pcm.
@@ -4692,6 +5880,22 @@ namespace build2
         rm.cancel ();
       }
 
+      if (!bck.empty ())
+        bmi_cache_save (*bcd, bck, tp, t.member->as<file> ().path ());
+
+      // Account for the object file (and .dwo) size in the statistics.
+      //
+      if (ops.stat ())
+      {
+        uint64_t n (output_size (relo));
+
+        if (md.split_dwarf)
+          n += output_size (relo.base () + ".dwo");
+
+        stat_object_bytes.fetch_add (static_cast<size_t> (n),
+                                     memory_order_relaxed);
+      }
+
       timestamp now (system_clock::now ());
       depdb::check_mtime (start, md.dd, tp, now);
 
@@ -4712,9 +5916,12 @@ namespace build2
 
       switch (ctype)
       {
-      case ct::gcc:   return clean_extra (a, t, {".d", x_pext, ".t"});
-      case ct::clang: return clean_extra (a, t, {".d", x_pext});
-      case ct::msvc:  return clean_extra (a, t, {".d", x_pext, ".idb", ".pdb"});
+      case ct::gcc:   return clean_extra (a, t, {".d", x_pext, ".t",
+                                                 ".batch/"});
+      case ct::clang: return clean_extra (a, t, {".d", x_pext,
+                                                 ".batch/"});
+      case ct::msvc:  return clean_extra (a, t, {".d", x_pext, ".idb", ".pdb",
+                                                 ".batch/"});
       case ct::icc:   return clean_extra (a, t, {".d"});
       }
 
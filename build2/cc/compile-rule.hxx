@@ -5,6 +5,8 @@
 #ifndef BUILD2_CC_COMPILE_RULE_HXX
 #define BUILD2_CC_COMPILE_RULE_HXX
 
+#include <map>
+
 #include <libbutl/path-map.mxx>
 
 #include <build2/types.hxx>
@@ -72,6 +74,50 @@ namespace build2
                         const target&,
                         linfo) const;
 
+      // Flattened interface closure of a prerequisite library: the
+      // libraries together with their *.export.poptions variables in the
+      // order process_libraries() visits them plus the concatenation of
+      // their values. Computed once per library, linfo, action, and base
+      // scope (the latter affects the resolution of imported libraries)
+      // and shared by all the translation units that depend on it (see
+      // lib_closure() for details).
+      //
+      struct lib_closure_entry
+      {
+        const file*     lib;
+        const variable* var;
+      };
+
+      struct lib_closure_value
+      {
+        vector<lib_closure_entry> entries;
+        strings                   options;
+      };
+
+      struct lib_closure_key
+      {
+        const scope* base;
+        const file*  lib;
+        otype        type;
+        lorder       order;
+        action_id    inner;
+        action_id    outer;
+
+        bool
+        operator< (const lib_closure_key&) const;
+      };
+
+      const lib_closure_value&
+      lib_closure (const scope&, action, const file&, bool, linfo) const;
+
+      template <typename F>
+      void
+      for_each_lib_closure (const scope&, action, const target&, linfo,
+                            F&&) const;
+
+      mutable shared_mutex                                lib_closure_mutex_;
+      mutable std::map<lib_closure_key, lib_closure_value> lib_closures_;
+
       // Mapping of include prefixes (e.g., foo in <foo/bar>) for auto-
       // generated headers to directories where they will be generated.
       //
@@ -103,9 +149,41 @@ namespace build2
                            target&,
                            linfo) const;
 
-      prefix_map
+      const prefix_map&
       build_prefix_map (const scope&, action, target&, linfo) const;
 
+      // Prefix map cache. Many translation units in a project share the
+      // same poptions values and prerequisite libraries so we build the
+      // map once for each such combination (see build_prefix_map() for
+      // details).
+      //
+      // Note that the entries are never removed: the build state they are
+      // derived from cannot change during match (only "island appends" are
+      // possible in the exclusive load phase) and the rule instance itself
+      // does not outlive this state. The map node stability allows us to
+      // return references to the cached values.
+      //
+      struct prefix_key
+      {
+        const scope*          base;
+        dir_path              dir;        // Target directory (out_base).
+        const value*          c_poptions;
+        const value*          x_poptions;
+        otype                 type;
+        lorder                order;
+        vector<const target*> libs;       // Prerequisite libraries.
+
+        bool
+        operator< (const prefix_key&) const;
+      };
+
+      mutable shared_mutex                     prefix_cache_mutex_;
+      mutable std::map<prefix_key, prefix_map> prefix_cache_;
+
+      size_t
+      pregenerate_headers (action, const scope&, file&, linfo,
+                           const prefix_map&) const;
+
       // Reverse-lookup target type from extension.
       //
       const target_type*
@@ -126,15 +204,61 @@ namespace build2
                        const file&, match_data&,
                        module_info&&, depdb&, bool&) const;
 
+      struct header_units;
+
       module_positions
       search_modules (action, const scope&, file&, linfo,
                       const target_type&,
-                      const file&, module_imports&, sha256&) const;
+                      const file&, module_imports&, sha256&,
+                      const header_units*) const;
+
+      dir_path
+      modules_sidebuild (const scope&) const;
 
       const target&
       make_module_sidebuild (action, const scope&, const target&,
                              const target&, const string&) const;
 
+      // Header units (see importable_header_units() for details).
+      //
+      struct header_unit
+      {
+        string      name;   // As specified in x.importable_headers.
+        path        header; // Absolute header path.
+        const file* bmi;    // Header unit bmi*{} in the modules sidebuild.
+      };
+
+      struct header_units
+      {
+        vector<header_unit> units;
+        path                map;     // Module mapper file (GCC), if any.
+        bool                updated; // BMIs updated (under the mutex).
+      };
+
+      struct header_units_key
+      {
+        const value*       headers;   // x.importable_headers value.
+        const target_type* bmi;       // bmi*{} type.
+        dir_path           sidebuild; // Modules sidebuild directory.
+
+        bool
+        operator< (const header_units_key&) const;
+      };
+
+      const header_units*
+      importable_header_units (action, const scope&, file&,
+                               const compile_target_types&) const;
+
+      const file&
+      make_header_sidebuild (const dir_path&, const target_type&,
+                             const file&, const path&) const;
+
+      void
+      append_header_units (cstrings&, strings&, const match_data&) const;
+
+      mutable shared_mutex                           header_units_mutex_;
+      mutable std::map<header_units_key, header_units> header_units_;
+
       void
       append_modules (environment&, cstrings&, strings&,
                       action, const file&, const match_data&) const;
@@ -147,6 +271,70 @@ namespace build2
       void
       append_symexport_options (cstrings&, const target&) const;
 
+      // Precompiled header options. If the storage is NULL, then we are
+      // preprocessing and the header itself is force-included instead of
+      // the PCH.
+      //
+      void
+      append_pch_options (cstrings&, const match_data&, string*) const;
+
+      const target*
+      search_pch_header (action, const target&) const;
+
+      // BMI cache (bmi-cache.cxx).
+      //
+      string
+      bmi_cache_key (action, const file&, const string&, size_t) const;
+
+      bool
+      bmi_cache_load (const dir_path&, const string&,
+                      const path& bmi, const path& obj) const;
+
+      void
+      bmi_cache_save (const dir_path&, const string&,
+                      const path& bmi, const path& obj) const;
+
+      // Batched compilation (see batch_compile() for details).
+      //
+      struct batch
+      {
+        struct member
+        {
+          const file* target;
+          path        src;    // What to compile (source or preprocessed).
+          path        dd;     // Dependency database.
+          bool        done;   // Compiled as part of the batch.
+        };
+
+        uint64_t       size;  // Maximum number of members.
+        vector<member> members;
+
+        // 2 - open, 1 - being compiled, 0 - done.
+        //
+        atomic_count   state {2};
+        timestamp      start; // Compilation start (see depdb::check_mtime()).
+        timestamp      mtime; // Compilation end.
+      };
+
+      batch*
+      batch_register (string key,
+                      uint64_t size,
+                      const file&,
+                      const path& src,
+                      const path& dd) const;
+
+      optional<timestamp>
+      batch_compile (batch&,
+                     const file&,
+                     const cstrings& args,
+                     size_t out_i,
+                     size_t out_n,
+                     const environment&) const;
+
+      mutable mutex                        batch_mutex_;
+      mutable std::map<string, batch*>     batch_map_; // Open batch for key.
+      mutable vector<unique_ptr<batch>>    batches_;
+
     private:
       const string rule_id;
     };
@@ -8,6 +8,7 @@
 #include <cstring>  // strlen(), strchr()
 
 #include <build2/diagnostics.hxx>
+#include <build2/probe-cache.hxx>
 
 using namespace std;
 
@@ -1649,11 +1650,86 @@ namespace build2
         move (xsl)};
     }
 
+    string
+    compiler_probe_key (const char* kind,
+                        const process_path& xc,
+                        const string& extra)
+    {
+      return probe_key (kind,
+                        xc,
+                        {"GCC_EXEC_PREFIX",
+                         "COMPILER_PATH",
+                         "LIBRARY_PATH",
+                         "CPATH",
+                         "C_INCLUDE_PATH",
+                         "CPLUS_INCLUDE_PATH",
+                         "SDKROOT",
+                         "INCLUDE",
+                         "LIB",
+                         "CL",
+                         "_CL_"},
+                        extra);
+    }
+
     // Compiler checks can be expensive (we often need to run the compiler
-    // several times) so we cache the result.
+    // several times) so we cache the result, both in memory and in the probe
+    // cache (see probe-cache.hxx for details).
     //
     static map<string, compiler_info> cache;
 
+    static strings
+    to_probe_data (const compiler_info& ci)
+    {
+      return strings {
+        ci.id.string (),
+        to_string (ci.class_),
+        ci.version.string,
+        std::to_string (ci.version.major),
+        std::to_string (ci.version.minor),
+        std::to_string (ci.version.patch),
+        ci.version.build,
+        ci.signature,
+        ci.checksum,
+        ci.target,
+        ci.original_target,
+        ci.pattern,
+        ci.bin_pattern,
+        ci.runtime,
+        ci.c_stdlib,
+        ci.x_stdlib};
+    }
+
+    static optional<compiler_info>
+    from_probe_data (process_path&& xp, strings&& d)
+    {
+      if (d.size () != 16 || (d[1] != "gcc" && d[1] != "msvc"))
+        return nullopt;
+
+      try
+      {
+        return compiler_info {
+          move (xp),
+          compiler_id (d[0]),
+          d[1] == "gcc" ? compiler_class::gcc : compiler_class::msvc,
+          compiler_version {
+            move (d[2]), stoull (d[3]), stoull (d[4]), stoull (d[5]),
+            move (d[6])},
+          move (d[7]),
+          move (d[8]),
+          move (d[9]),
+          move (d[10]),
+          move (d[11]),
+          move (d[12]),
+          move (d[13]),
+          move (d[14]),
+          move (d[15])};
+      }
+      catch (const invalid_argument&) {}
+      catch (const out_of_range&) {}
+
+      return nullopt;
+    }
+
     const compiler_info&
     guess (const char* xm,
            lang xl,
@@ -1663,8 +1739,11 @@ namespace build2
            const string* xt,
            const strings* c_po, const strings* x_po,
            const strings* c_co, const strings* x_co,
-           const strings* c_lo, const strings* x_lo)
+           const strings* c_lo, const strings* x_lo,
+           const dir_path& out_root)
     {
+      tracer trace ("cc::guess");
+
       // First check the cache.
       //
       string key;
@@ -1686,6 +1765,33 @@ namespace build2
           return i->second;
       }
 
+      // Then check the probe cache. Here the key also includes the version
+      // and target overrides. Note that searching for the compiler is cheap
+      // (doesn't involve running anything).
+      //
+      const char* kind ("cc.guess-1");
+      string pkey;
+      {
+        process_path xp (
+          process::try_path_search (xc, false, dir_path (), true));
+
+        string e (key);
+        e += '\n'; if (xv != nullptr) e += *xv;
+        e += '\n'; if (xt != nullptr) e += *xt;
+
+        pkey = compiler_probe_key (kind, xp, e);
+
+        if (optional<strings> d = probe_load (out_root, kind, pkey))
+        {
+          if (optional<compiler_info> r =
+              from_probe_data (move (xp), move (*d)))
+          {
+            l4 ([&]{trace << "cached " << xl << " compiler " << r->id;});
+            return (cache[key] = move (*r));
+          }
+        }
+      }
+
       // Parse the user-specified compiler id (config.x.id).
       //
       optional<compiler_id> xi;
@@ -1836,6 +1942,8 @@ namespace build2
           r.bin_pattern = p.directory ().representation (); // Trailing slash.
       }
 
+      probe_save (out_root, kind, pkey, to_probe_data (r));
+
       return (cache[key] = move (r));
     }
 
@@ -231,7 +231,17 @@ namespace build2
            const string* xt,  // Compiler target (optional).
            const strings* c_poptions, const strings* x_poptions,
            const strings* c_coptions, const strings* x_coptions,
-           const strings* c_loptions, const strings* x_loptions);
+           const strings* c_loptions, const strings* x_loptions,
+           const dir_path& out_root); // Probe cache (see probe-cache.hxx).
+
+    // Return the probe cache key for the compiler that also incorporates the
+    // environment variables affecting its behavior (see probe-cache.hxx for
+    // details).
+    //
+    string
+    compiler_probe_key (const char* kind,
+                        const process_path&,
+                        const string& extra);
 
     // Given a language, compiler id, and optionally an (empty) pattern,
     // return an appropriate default compiler path.
@@ -0,0 +1,410 @@
+// file      : build2/cc/header-units.cxx -*- C++ -*-
+// copyright : Copyright (c) 2014-2019 Code Synthesis Ltd
+// license   : MIT; see accompanying LICENSE file
+
+#include <build2/scope.hxx>
+#include <build2/target.hxx>
+#include <build2/context.hxx>
+#include <build2/variable.hxx>
+#include <build2/algorithm.hxx>
+#include <build2/filesystem.hxx>
+#include <build2/diagnostics.hxx>
+
+#include <build2/cc/target.hxx> // h
+#include <build2/cc/compile-rule.hxx>
+
+using namespace std;
+using namespace butl;
+
+namespace build2
+{
+  namespace cc
+  {
+    bool compile_rule::header_units_key::
+    operator< (const header_units_key& y) const
+    {
+      if (headers != y.headers) return headers < y.headers;
+      if (bmi != y.bmi) return bmi < y.bmi;
+      return sidebuild.compare (y.sidebuild) < 0;
+    }
+
+    // Importable headers (C++20 header units).
+    //
+    // The x.importable_headers variable lists the headers (normally from the
+    // standard library) that can be imported as header units and for which
+    // #include is translated to import. Each is compiled once per modules
+    // sidebuild (that is, per configuration) and BMI type into a bmi*{}
+    // target in the sidebuild, which is then shared by all the translation
+    // units that import (or #include) it.
+    //
+    // Because a header unit exports macros, its BMI is needed to preprocess
+    // (and not only to compile) the translation unit. And since we don't
+    // know which headers a translation unit imports until we have
+    // preprocessed it, we make sure the BMIs of all the importable headers
+    // are up-to-date before that, updating them directly (in the execute
+    // phase) the first time they are needed. For GCC we also write the
+    // module mapper file that maps all the importable headers to their BMIs
+    // and that is used when preprocessing, which is also when GCC translates
+    // the #include directives (the result is import declarations in the
+    // preprocessed output that we then handle like any other import).
+    //
+    // Note that the header units are compiled with the options of the
+    // sidebuild project rather than of the translation units that import
+    // them and it is the user's responsibility to make sure these are
+    // compatible (the compiler will normally complain if they are not).
+    //
+    const compile_rule::header_units* compile_rule::
+    importable_header_units (action a,
+                             const scope& bs,
+                             file& t,
+                             const compile_target_types& tt) const
+    {
+      tracer trace (x, "compile_rule::importable_header_units");
+
+      lookup l (t[*x_importable_headers]);
+
+      if (!l || cast<strings> (l).empty ())
+        return nullptr;
+
+      const strings& hs (cast<strings> (l));
+
+      header_units_key k {l.value, &tt.bmi, modules_sidebuild (bs)};
+
+      header_units* r (nullptr);
+      {
+        slock sl (header_units_mutex_);
+
+        auto i (header_units_.find (k));
+        if (i != header_units_.end ())
+        {
+          r = &i->second;
+
+          if (r->updated)
+            return r;
+        }
+      }
+
+      // Resolve the headers and synthesize their header units. Note that we
+      // cannot do this while holding the lock since we may need to switch
+      // the phase. So several threads may end up doing this at the same time
+      // but only the first one gets to keep the result (and the targets will
+      // be the same anyway).
+      //
+      if (r == nullptr)
+      {
+        header_units hus;
+        hus.updated = false;
+
+        for (const string& n: hs)
+        {
+          path p;
+          try
+          {
+            if (n.size () > 2 && n.front () == '<' && n.back () == '>')
+            {
+              path f (string (n, 1, n.size () - 2));
+
+              for (const dir_path& d: sys_inc_dirs)
+              {
+                path c (d / f);
+
+                if (file_exists (c))
+                {
+                  p = move (c);
+                  break;
+                }
+              }
+
+              if (p.empty ())
+                fail << "unable to resolve importable header " << n <<
+                  info << "not found in " << x_name << " system header "
+                       << "search directories";
+            }
+            else
+            {
+              p = path (n);
+
+              if (p.relative ())
+                fail << "relative importable header " << n <<
+                  info << "specify absolute path or <>-name in "
+                       << x_importable_headers->name;
+            }
+
+            p.normalize ();
+          }
+          catch (const invalid_path& e)
+          {
+            fail << "invalid importable header '" << e.path << "'";
+          }
+
+          // Find or insert the header target similar to extract_headers()
+          // (if the file has no extension, we record an empty extension).
+          //
+          dir_path d (p.directory ());
+          string e (p.extension ());
+          string hn (p.leaf ().string ());
+
+          if (!e.empty ())
+            hn.resize (hn.size () - e.size () - 1);
+
+          const target_type* htt (nullptr);
+          {
+            const scope& s (scopes.find (d));
+            if (s.root_scope () != nullptr)
+              htt = map_extension (s, hn, e);
+          }
+
+          if (htt == nullptr)
+            htt = &h::static_type;
+
+          const file& ht (
+            search (t, *htt, d, dir_path (), hn, &e, nullptr).as<file> ());
+
+          const file& bt (make_header_sidebuild (k.sidebuild, tt.bmi, ht, p));
+          hus.units.push_back (header_unit {n, move (p), &bt});
+        }
+
+        // Match in parallel. This also assigns the BMI paths.
+        //
+        // Note that we are not (yet) a dependent of these BMIs: the ones
+        // that are actually imported are matched and executed as our
+        // prerequisites as any other module (see search_modules()). So we
+        // unmatch those that are unchanged and add the rest to our
+        // prerequisite targets so that the dependency counts that match()
+        // incremented are decremented when we are executed.
+        //
+        {
+          wait_guard wg (target::count_busy (), t[a].task_count, true);
+
+          for (const header_unit& u: hus.units)
+            match_async (a, *u.bmi, target::count_busy (), t[a].task_count);
+
+          wg.wait ();
+        }
+
+        auto& pts (t.prerequisite_targets[a]);
+
+        for (const header_unit& u: hus.units)
+        {
+          if (!build2::match (a, *u.bmi, unmatch::unchanged))
+            pts.push_back (u.bmi);
+        }
+
+        // The module mapper file for GCC is named after the BMI type and is
+        // only rewritten if its contents have changed. We write it while
+        // holding the lock so that no one can see it partially written.
+        //
+        string mc;
+        if (ctype == compiler_type::gcc)
+        {
+          hus.map = k.sidebuild / path (string (tt.bmi.name) + ".map");
+
+          for (const header_unit& u: hus.units)
+          {
+            mc += u.header.string ();
+            mc += ' ';
+            mc += u.bmi->path ().string ();
+            mc += '\n';
+          }
+        }
+
+        ulock ul (header_units_mutex_);
+
+        auto p (header_units_.emplace (move (k), move (hus)));
+        r = &p.first->second;
+
+        if (p.second && !r->map.empty ())
+        {
+          const path& f (r->map);
+
+          try
+          {
+            string oc;
+            if (file_exists (f))
+            {
+              ifdstream ifs (f);
+              oc = ifs.read_text ();
+            }
+
+            if (oc != mc)
+            {
+              if (verb >= 3)
+                text << "cat >" << f;
+
+              ofdstream ofs (f);
+              ofs << mc;
+              ofs.close ();
+            }
+          }
+          catch (const io_error& e)
+          {
+            fail << "unable to write to " << f << ": " << e;
+          }
+        }
+
+        if (r->updated)
+          return r;
+      }
+
+      // Update in parallel (see pregenerate_headers() for background).
+      //
+      l5 ([&]{trace << "updating " << r->units.size () << " header units "
+                    << "for " << t;});
+
+      vector<target_state> rs (r->units.size (), target_state::unknown);
+      {
+        phase_switch ps (run_phase::execute);
+
+        atomic_count task_count (0);
+        wait_guard wg (task_count);
+
+        for (size_t i (0); i != r->units.size (); ++i)
+        {
+          sched.async (task_count,
+                       [a] (const diag_frame* ds,
+                            const target& b,
+                            target_state& s)
+                       {
+                         diag_frame::stack_guard dsg (ds);
+
+                         try
+                         {
+                           s = execute_direct (a, b);
+                         }
+                         catch (const failed&)
+                         {
+                           s = target_state::failed;
+                         }
+                       },
+                       diag_frame::stack,
+                       cref (*r->units[i].bmi),
+                       ref (rs[i]));
+        }
+
+        wg.wait ();
+      }
+
+      for (target_state s: rs)
+      {
+        if (s == target_state::failed)
+          throw failed (); // Diagnostics has already been issued.
+      }
+
+      ulock ul (header_units_mutex_);
+      r->updated = true;
+      return r;
+    }
+
+    // Synthesize a dependency for building a header unit on the side (see
+    // make_module_sidebuild() for background).
+    //
+    const file& compile_rule::
+    make_header_sidebuild (const dir_path& pd,
+                           const target_type& tt,
+                           const file& ht,
+                           const path& hp) const
+    {
+      tracer trace (x, "compile_rule::make_header_sidebuild");
+
+      // The same header name can come from different directories (think
+      // <stdio.h> and <sys/stdio.h>) so we add an abbreviated checksum of
+      // the header path to the name. We also replace '.' with '-' so that it
+      // is not mistaken for the extension.
+      //
+      string n;
+      {
+        const string& l (hp.leaf ().string ());
+        transform (l.begin (), l.end (),
+                   back_inserter (n),
+                   [] (char c) {return c == '.' ? '-' : c;});
+
+        n += '-';
+        n.append (sha256 (hp.string ()).string (), 0, 8);
+      }
+
+      if (const target* bt = targets.find (
+            tt,
+            pd,
+            dir_path (), // Always in the out tree.
+            n,
+            nullopt,     // Use default extension.
+            trace))
+        return bt->as<file> ();
+
+      prerequisites ps;
+      ps.push_back (prerequisite (ht));
+
+      auto p (targets.insert_locked (tt,
+                                     pd,
+                                     dir_path (), // Always in the out tree.
+                                     move (n),
+                                     nullopt,     // Use default extension.
+                                     true,        // Implied.
+                                     trace));
+      const target& bt (p.first);
+
+      // Note that this is racy and someone might have created this target
+      // while we were preparing the prerequisite list.
+      //
+      if (p.second.owns_lock ())
+        bt.prerequisites (move (ps));
+
+      return bt.as<file> ();
+    }
+
+    // Append the options that make the importable header units available
+    // when preprocessing (see perform_update() for compilation).
+    //
+    void compile_rule::
+    append_header_units (cstrings& args,
+                         strings& stor,
+                         const match_data& md) const
+    {
+      if (md.hus == nullptr)
+        return;
+
+      const header_units& hus (*md.hus);
+
+      switch (ctype)
+      {
+      case compiler_type::gcc:
+        {
+          stor.push_back ("-fmodule-mapper=" + hus.map.string ());
+
+          // Keep the module dependency information out of the make
+          // dependency output that we parse.
+          //
+          stor.push_back ("-Mno-modules");
+          break;
+        }
+      case compiler_type::clang:
+        {
+          for (const header_unit& u: hus.units)
+            stor.push_back ("-fmodule-file=" + u.bmi->path ().string ());
+
+          break;
+        }
+      case compiler_type::msvc:
+        {
+          stor.push_back ("/translateInclude");
+
+          for (const header_unit& u: hus.units)
+          {
+            stor.push_back ("/headerUnit");
+            stor.push_back (u.header.string () + '=' +
+                            u.bmi->path ().string ());
+          }
+
+          break;
+        }
+      case compiler_type::icc:
+        break;
+      }
+
+      // Shallow-copy storage to args (see append_modules() for details).
+      //
+      for (const string& a: stor)
+        args.push_back (a.c_str ());
+    }
+  }
+}
@@ -85,15 +85,18 @@ namespace build2
       v.insert<strings> ("config.cc.loptions", true);
       v.insert<strings> ("config.cc.libs",     true);
 
-      v.insert<strings> ("cc.poptions");
-      v.insert<strings> ("cc.coptions");
-      v.insert<strings> ("cc.loptions");
-      v.insert<strings> ("cc.libs");
+      // These are looked up by the rules on every target so give them fast
+      // slots (see variable_pool::insert_slot()).
+      //
+      v.insert_slot<strings> ("cc.poptions");
+      v.insert_slot<strings> ("cc.coptions");
+      v.insert_slot<strings> ("cc.loptions");
+      v.insert_slot<strings> ("cc.libs");
 
-      v.insert<strings>      ("cc.export.poptions");
-      v.insert<strings>      ("cc.export.coptions");
-      v.insert<strings>      ("cc.export.loptions");
-      v.insert<vector<name>> ("cc.export.libs");
+      v.insert_slot<strings>      ("cc.export.poptions");
+      v.insert_slot<strings>      ("cc.export.coptions");
+      v.insert_slot<strings>      ("cc.export.loptions");
+      v.insert_slot<vector<name>> ("cc.export.libs");
 
       // Hint variables (not overridable).
       //
@@ -117,12 +120,12 @@ namespace build2
       // but specific language is not known. Used in the import installed
       // logic.
       //
-      v.insert<string> ("cc.type", v_t);
+      v.insert_slot<string> ("cc.type", v_t);
 
       // If set and is true, then this (imported) library has been found in a
       // system library search directory.
       //
-      v.insert<bool> ("cc.system", v_t);
+      v.insert_slot<bool> ("cc.system", v_t);
 
       // C++ module name. Set on the bmi*{} target as a rule-specific variable
       // by the matching rule. Can also be set by the user (normally via the
@@ -135,6 +138,41 @@ namespace build2
       v.insert<bool> ("config.cc.reprocess", true);
       v.insert<bool> ("cc.reprocess");
 
+      // Ability to update generated headers before extracting header
+      // dependencies (see compile_rule::extract_headers() for details).
+      //
+      v.insert<bool> ("config.cc.pregenerate", true);
+      v.insert<bool> ("cc.pregenerate");
+
+      // Maximum number of translation units to compile with a single
+      // compiler invocation (see compile_rule::batch_compile() for details).
+      //
+      v.insert<uint64_t> ("config.cc.batch", true);
+      v.insert<uint64_t> ("cc.batch");
+
+      // Directory of the BMI cache shared between configurations (see
+      // compile_rule::bmi_cache_key() for details).
+      //
+      v.insert<dir_path> ("config.cc.bmi_cache", true);
+      v.insert<dir_path> ("cc.bmi_cache");
+
+      // Split DWARF (-gsplit-dwarf) and compressed debug sections (-gz) for
+      // GCC and Clang on ELF targets. Both only have effect if debug
+      // information is requested (some -g option other than -g0).
+      //
+      v.insert<bool> ("config.cc.split_dwarf", true);
+      v.insert<bool> ("cc.split_dwarf");
+
+      v.insert<bool> ("config.cc.compress_debug", true);
+      v.insert<bool> ("cc.compress_debug");
+
+      // The dwp tool (for example, dwp or llvm-dwp) to package the .dwo files
+      // of executables and shared libraries into .dwp after linking. Only
+      // used with cc.split_dwarf.
+      //
+      v.insert<path> ("config.cc.dwp", true);
+      v.insert<path> ("cc.dwp");
+
       // Register scope operation callback.
       //
       // It feels natural to do clean up sidebuilds as a post operation but
@@ -263,6 +301,24 @@ namespace build2
       if (lookup l = config::omitted (rs, "config.cc.reprocess").first)
         rs.assign ("cc.reprocess") = *l;
 
+      if (lookup l = config::omitted (rs, "config.cc.pregenerate").first)
+        rs.assign ("cc.pregenerate") = *l;
+
+      if (lookup l = config::omitted (rs, "config.cc.batch").first)
+        rs.assign ("cc.batch") = *l;
+
+      if (lookup l = config::omitted (rs, "config.cc.bmi_cache").first)
+        rs.assign ("cc.bmi_cache") = *l;
+
+      if (lookup l = config::omitted (rs, "config.cc.split_dwarf").first)
+        rs.assign ("cc.split_dwarf") = *l;
+
+      if (lookup l = config::omitted (rs, "config.cc.compress_debug").first)
+        rs.assign ("cc.compress_debug") = *l;
+
+      if (lookup l = config::omitted (rs, "config.cc.dwp").first)
+        rs.assign ("cc.dwp") = *l;
+
       // Load the bin.config module.
       //
       if (!cast_false<bool> (rs["bin.config.loaded"]))
@@ -4,6 +4,10 @@
 
 #include <build2/cc/lexer.hxx>
 
+#ifdef __SSE2__
+#  include <emmintrin.h>
+#endif
+
 using namespace std;
 using namespace butl;
 
@@ -28,6 +32,83 @@ static const uint8_t char_flags[256] =
   0,0,0,0,0,0,0,0,  0,0,0,0,0,0,0,0, 0,0,0,0,0,0,0,0,  0,0,0,0,0,0,0,0
 };
 
+// Direct buffer scan helpers.
+//
+// Comments and string literals are often long enough for it to be worth
+// examining 16 characters at a time. If SSE2 is not available, we fall back
+// to the character-by-character scan (the same applies to the tail of the
+// range).
+//
+// Return the pointer to the first character in [b, e) that is equal to one
+// of the specified characters or e if there is none.
+//
+static inline const char*
+find_any (const char* b, const char* e, char c1, char c2, char c3)
+{
+  const char* p (b);
+
+#ifdef __SSE2__
+  const __m128i v1 (_mm_set1_epi8 (c1));
+  const __m128i v2 (_mm_set1_epi8 (c2));
+  const __m128i v3 (_mm_set1_epi8 (c3));
+
+  for (; e - p >= 16; p += 16)
+  {
+    __m128i d (_mm_loadu_si128 (reinterpret_cast<const __m128i*> (p)));
+
+    int m (_mm_movemask_epi8 (
+             _mm_or_si128 (_mm_or_si128 (_mm_cmpeq_epi8 (d, v1),
+                                         _mm_cmpeq_epi8 (d, v2)),
+                           _mm_cmpeq_epi8 (d, v3))));
+    if (m != 0)
+      return p + __builtin_ctz (static_cast<unsigned int> (m));
+  }
+#endif
+
+  for (char c; p != e && (c = *p) != c1 && c != c2 && c != c3; ++p) ;
+  return p;
+}
+
+static inline const char*
+find_any (const char* b, const char* e, char c1, char c2)
+{
+  return find_any (b, e, c1, c2, c2);
+}
+
+static inline const char*
+find_any (const char* b, const char* e, char c)
+{
+  return find_any (b, e, c, c, c);
+}
+
+// Return the pointer to the first character in [b, e) that is not equal to
+// either of the specified characters or e if there is none.
+//
+static inline const char*
+find_not (const char* b, const char* e, char c1, char c2)
+{
+  const char* p (b);
+
+#ifdef __SSE2__
+  const __m128i v1 (_mm_set1_epi8 (c1));
+  const __m128i v2 (_mm_set1_epi8 (c2));
+
+  for (; e - p >= 16; p += 16)
+  {
+    __m128i d (_mm_loadu_si128 (reinterpret_cast<const __m128i*> (p)));
+
+    int m (~_mm_movemask_epi8 (_mm_or_si128 (_mm_cmpeq_epi8 (d, v1),
+                                             _mm_cmpeq_epi8 (d, v2))) &
+           0xFFFF);
+    if (m != 0)
+      return p + __builtin_ctz (static_cast<unsigned int> (m));
+  }
+#endif
+
+  for (char c; p != e && ((c = *p) == c1 || c == c2); ++p) ;
+  return p;
+}
+
 // Diagnostics plumbing.
 //
 namespace butl // ADL
@@ -172,8 +253,16 @@ namespace build2
         // when changed with the #line directive (as well as in the
         // constructor for the initial path).
         //
-        cs_.append (t.line);
-        cs_.append (c);
+        // If the line numbers are not part of the object file (no debug
+        // info, etc), then we can omit them. In this case we also don't hash
+        // the #line directives since the preprocessor may use them instead
+        // of blank lines (see the '#' case below).
+        //
+        if (lines_)
+          cs_.append (t.line);
+
+        if (lines_ || c != '#')
+          cs_.append (c);
 
         switch (c)
         {
@@ -221,6 +310,10 @@ namespace build2
                   {
                     next (t, c, false);
 
+                    if (!lines_ &&
+                        (t.type != type::identifier || t.value != "line"))
+                      cs_.append ('#');
+
                     if (t.type == type::identifier)
                     {
                       if (t.value == "include")
@@ -252,6 +345,9 @@ namespace build2
             }
             else
             {
+              if (!lines_)
+                cs_.append (c);
+
               t.type = type::punctuation;
               return;
             }
@@ -531,6 +627,62 @@ namespace build2
       }
     }
 
+    token_type lexer::
+    next_header (token& t)
+    {
+      xchar c (skip_spaces ());
+
+      if (c != '<' && c != '\"')
+      {
+        next (t, c, true);
+        return t.type;
+      }
+
+      // Note: hashed the same way as any other token (see next()).
+      //
+      t.file = log_file_;
+      t.line = log_line_ ? *log_line_ : c.line;
+      t.column = c.column;
+
+      if (lines_)
+        cs_.append (t.line);
+
+      cs_.append (c);
+
+      const location l (&name_, c.line, c.column);
+
+      // There are no escape sequences in header names.
+      //
+      char d (c == '<' ? '>' : '\"');
+
+      t.value.clear ();
+
+      if (d == '>')
+        t.value += '<';
+
+      for (;;)
+      {
+        c = geth ();
+
+        if (eos (c) || c == '\n')
+          fail (l) << "unterminated header name";
+
+        if (c == d)
+          break;
+
+        t.value += static_cast<char> (c);
+      }
+
+      if (t.value.size () == (d == '>' ? 1 : 0))
+        fail (l) << "empty header name";
+
+      if (d == '>')
+        t.value += '>';
+
+      t.type = type::header_name;
+      return t.type;
+    }
+
     void lexer::
     number_literal (token& t, xchar c)
     {
@@ -694,12 +846,7 @@ namespace build2
         if (p != '\\')
         {
           const char* b (gptr_);
-          const char* e (egptr_);
-          const char* p (b);
-
-          for (char c;
-               p != e && (c = *p) != '\"' && c != '\\' && c != '\n';
-               ++p) ;
+          const char* p (find_any (b, egptr_, '\"', '\\', '\n'));
 
           size_t n (p - b);
           cs_.append (b, n);
@@ -770,6 +917,21 @@ namespace build2
           if (++i == d.size ())
             break;
         }
+
+        // Direct buffer scan until the beginning of the closing delimiter.
+        // Note that we don't do any newline or CRLF processing here (see
+        // the constructor).
+        //
+        if (i == 0)
+        {
+          const char* b (gptr_);
+          const char* p (find_any (b, egptr_, ')'));
+
+          size_t n (p - b);
+          cs_.append (b, n);
+          skip_lines (b, p);
+          gptr_ = p; buf_->gbump (static_cast<int> (n));
+        }
       }
 
       // See if we have a user-defined suffix (which is an identifier).
@@ -974,6 +1136,25 @@ namespace build2
         unget (c);
     }
 
+    void lexer::
+    skip_lines (const char* b, const char* e)
+    {
+      // Note: the same line/column logic as in char_scanner::get().
+      //
+      const char* l (nullptr); // Last newline.
+
+      for (const char* p (b); (p = find_any (p, e, '\n')) != e; l = p++)
+      {
+        if (log_line_) ++*log_line_;
+        ++line;
+      }
+
+      if (l != nullptr)
+        column = static_cast<uint64_t> (e - l);
+      else
+        column += e - b;
+    }
+
     auto lexer::
     skip_spaces (bool nl) -> xchar
     {
@@ -995,12 +1176,7 @@ namespace build2
             // Direct buffer scan.
             //
             const char* b (gptr_);
-            const char* e (egptr_);
-            const char* p (b);
-
-            for (char c;
-                 p != e && ((c = *p) == ' ' || c == '\t');
-                 ++p) ;
+            const char* p (find_not (b, egptr_, ' ', '\t'));
 
             size_t n (p - b);
             gptr_ = p; buf_->gbump (static_cast<int> (n)); column += n;
@@ -1026,12 +1202,7 @@ namespace build2
                 // Direct buffer scan.
                 //
                 const char* b (gptr_);
-                const char* e (egptr_);
-                const char* p (b);
-
-                for (char c;
-                     p != e && (c = *p) != '\n' && c != '\\';
-                     ++p) ;
+                const char* p (find_any (b, egptr_, '\n', '\\'));
 
                 size_t n (p - b);
                 gptr_ = p; buf_->gbump (static_cast<int> (n)); column += n;
@@ -1065,23 +1236,9 @@ namespace build2
                 // Direct buffer scan.
                 //
                 const char* b (gptr_);
-                const char* e (egptr_);
-                const char* p (b);
-
-                for (char c;
-                     p != e && (c = *p) != '*' && c != '\\';
-                     ++p)
-                {
-                  if (c == '\n')
-                  {
-                    if (log_line_) ++*log_line_;
-                    ++line;
-                    column = 1;
-                  }
-                  else
-                    ++column;
-                }
+                const char* p (find_any (b, egptr_, '*', '\\'));
 
+                skip_lines (b, p);
                 gptr_ = p; buf_->gbump (static_cast<int> (p - b));
               }
               continue;
@@ -1111,6 +1268,7 @@ namespace build2
       case type::number:      o << "<number literal>";      break;
       case type::character:   o << "<char literal>";        break;
       case type::string:      o << "<string literal>";      break;
+      case type::header_name: o << "<header name>";         break;
 
       case type::other:       o << "<other>";               break;
       case type::eos:         o << "<end of file>";         break;
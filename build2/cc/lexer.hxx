@@ -30,7 +30,8 @@ namespace build2
     //
     // While at it we also calculate the checksum of the input ignoring
     // comments, whitespaces, etc. This is used to detect changes that do not
-    // alter the resulting token stream.
+    // alter the resulting token stream. Unless lines is false, the checksum
+    // also includes the token line numbers (see next() for details).
     //
     enum class token_type
     {
@@ -50,6 +51,8 @@ namespace build2
       character,   // Char   literal.
       string,      // String literal.
 
+      header_name, // Header name (see next_header()).
+
       other        // Other token.
     };
 
@@ -77,9 +80,10 @@ namespace build2
     class lexer: protected butl::char_scanner
     {
     public:
-      lexer (ifdstream& is, const path& name)
+      lexer (ifdstream& is, const path& name, bool lines = true)
           : char_scanner (is, false),
             name_ (name),
+            lines_ (lines),
             fail ("error", &name_),
             log_file_ (name) {}
 
@@ -112,6 +116,16 @@ namespace build2
         return t.type;
       }
 
+      // As above but recognize the header-name (<...> or "...") that may
+      // follow the import keyword, in which case return header_name with
+      // the value being the name with the <> delimiters preserved and the
+      // "" delimiters stripped. Note that the latter is also the form (with
+      // the absolute path) in which some compilers (GCC) write the header
+      // unit imports into the preprocessed output.
+      //
+      token_type
+      next_header (token&);
+
     private:
       void
       next (token&, xchar, bool);
@@ -137,6 +151,12 @@ namespace build2
       xchar
       skip_spaces (bool newline = true);
 
+      // Account for the lines and columns of the [b, e) range that was
+      // consumed with a direct buffer scan.
+      //
+      void
+      skip_lines (const char* b, const char* e);
+
       // The char_scanner adaptation for newline escape sequence processing.
       // Enabled by default and is only disabled in the raw string literals.
       //
@@ -162,6 +182,7 @@ namespace build2
 
     private:
       const path name_;
+      bool lines_;
       const fail_mark fail;
 
       // Logical file and line as set by the #line directives. Note that the
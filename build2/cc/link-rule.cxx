@@ -6,7 +6,6 @@
 
 #include <map>
 #include <cstdlib>  // exit()
-#include <cstring>  // strlen()
 
 #include <libbutl/path-map.mxx>
 #include <libbutl/filesystem.mxx> // file_exists()
@@ -21,7 +20,7 @@
 
 #include <build2/bin/target.hxx>
 
-#include <build2/cc/target.hxx>  // c, pc*
+#include <build2/cc/target.hxx>  // c, pc*, pch, dwp
 #include <build2/cc/utility.hxx>
 
 using std::map;
@@ -38,7 +37,7 @@ namespace build2
     link_rule::
     link_rule (data&& d)
         : common (move (d)),
-          rule_id (string (x) += ".link 1")
+          rule_id (string (x) += ".link 2")
     {
       static_assert (sizeof (match_data) <= target::data_size,
                      "insufficient space");
@@ -412,6 +411,11 @@ namespace build2
         return a.operation () == clean_id && !pt->dir.sub (rs.out_path ());
       };
 
+      // If this is a unity build, partition the sources into batches (see
+      // unity_partition() for details).
+      //
+      unity_batches ubs (unity_partition (a, t, tt));
+
       auto& pts (t.prerequisite_targets[a]);
       size_t start (pts.size ());
 
@@ -419,6 +423,10 @@ namespace build2
       {
         include_type pi (include (a, t, p));
 
+        size_t ub (ubs.members.empty ()
+                   ? 0
+                   : ubs.members[pts.size () - start]);
+
         // We pre-allocate a NULL slot for each (potential; see clean)
         // prerequisite target.
         //
@@ -442,6 +450,28 @@ namespace build2
         {
           binless = binless && false;
 
+          // If this source is a unity batch member, then the first member
+          // stands for the batch object file and the rest are ignored (see
+          // pass 2 for the rest of the chaining).
+          //
+          if (ub != 0)
+          {
+            if (ubs.seen[ub - 1])
+              continue;
+
+            ubs.seen[ub - 1] = true;
+            pt = &ubs.batches[ub - 1].obj;
+
+            if (skip (pt))
+            {
+              pt = nullptr;
+              continue;
+            }
+
+            mark (pt, 1);
+            continue;
+          }
+
           // Rule chaining, part 1.
           //
 
@@ -535,11 +565,12 @@ namespace build2
         }
         else
         {
-          // If this is the obj{} or bmi{} target group, then pick the
-          // appropriate member.
+          // If this is the obj{}, bmi{}, or pch{} target group, then pick
+          // the appropriate member.
           //
           if      (p.is_a<obj> ()) pt = &search (t, tt.obj, p.key ());
           else if (p.is_a<bmi> ()) pt = &search (t, tt.bmi, p.key ());
+          else if (p.is_a<pch> ()) pt = &search (t, tt.pch, p.key ());
           //
           // Windows module definition (.def). For other platforms (and for
           // static libraries) treat it as an ordinary prerequisite.
@@ -747,6 +778,29 @@ namespace build2
             }
           }
 
+          // Add the split DWARF package (.dwp) if requested (see
+          // perform_update() for details). The debugger looks for it next to
+          // the executable or library so that's where we install it.
+          //
+          if (!binless && ot != otype::a && split_dwarf (t))
+          {
+            lookup l (t[c_dwp]);
+
+            if (l && !cast<path> (l).empty ())
+            {
+              target_lock dp (add_adhoc_member<cc::dwp> (a, t));
+              dp.target->as<file> ().derive_path (t.path ());
+
+              if (const variable* v = var_pool.find ("install"))
+              {
+                if (lookup il = t[*v])
+                  dp.target->assign (*v) = *il;
+              }
+
+              match_recipe (dp, group_recipe); // Set recipe and unlock.
+            }
+          }
+
           // Add pkg-config's .pc file.
           //
           // Note that we do it regardless of whether we are installing or not
@@ -853,10 +907,17 @@ namespace build2
         {
           bool mod (m == 2);
 
+          // The unity batch object file is always the member and its only
+          // source is the generated batch.
+          //
+          size_t ui (ubs.members.empty () ? 0 : ubs.members[i - 1 - start]);
+          const unity_batch* ub (ui != 0 ? &ubs.batches[ui - 1] : nullptr);
+
           m = 1;
 
           const target& rt (*pt);
-          bool group (!p.prerequisite.belongs (t)); // Group's prerequisite.
+          bool group (ub == nullptr &&
+                      !p.prerequisite.belongs (t)); // Group's prerequisite.
 
           // If we have created a obj/bmi{} target group, pick one of its
           // members; the rest would be primarily concerned with it.
@@ -884,11 +945,13 @@ namespace build2
           if (!pt->has_prerequisites () &&
               (!group || !rt.has_prerequisites ()))
           {
-            prerequisites ps {p.as_prerequisite ()}; // Source.
+            prerequisites ps {ub != nullptr           // Source.
+                              ? prerequisite (ub->src)
+                              : p.as_prerequisite ()};
 
-            // Add our lib*{} (see the export.* machinery for details) and
-            // bmi*{} (both original and chained; see module search logic)
-            // prerequisites.
+            // Add our lib*{} (see the export.* machinery for details),
+            // bmi*{} (both original and chained; see module search logic),
+            // and pch*{} (see the compile rule) prerequisites.
             //
             // Note that we don't resolve lib{} to liba{}/libs{} here
             // instead leaving it to whomever (e.g., the compile rule) will
@@ -918,7 +981,8 @@ namespace build2
               //
               if (p.is_a<libx> () ||
                   p.is_a<liba> () || p.is_a<libs> () || p.is_a<libux> () ||
-                  p.is_a<bmi> ()  || p.is_a (tt.bmi))
+                  p.is_a<bmi> ()  || p.is_a (tt.bmi) ||
+                  p.is_a<pch> ()  || p.is_a (tt.pch))
               {
                 ps.push_back (p.as_prerequisite ());
               }
@@ -969,7 +1033,10 @@ namespace build2
               verify = pt->has_prerequisites ();
           }
 
-          if (verify)
+          // The batch object file is private to this target so whatever
+          // prerequisites it already has must have been synthesized by us.
+          //
+          if (verify && ub == nullptr)
           {
             // This gets a bit tricky. We need to make sure the source files
             // are the same which we can only do by comparing the targets to
@@ -996,12 +1063,13 @@ namespace build2
               }
 
               // Ignore some known target types (fsdir, headers, libraries,
-              // modules).
+              // modules, precompiled headers).
               //
               if (p1.is_a<fsdir> ()                                         ||
                   p1.is_a<libx>  ()                                         ||
                   p1.is_a<liba> () || p1.is_a<libs> () || p1.is_a<libux> () ||
                   p1.is_a<bmi>  () || p1.is_a<bmix> ()                      ||
+                  p1.is_a<pch>  () || p1.is_a<pchx> ()                      ||
                   (p.is_a (mod ? *x_mod : x_src) && x_header (p1))          ||
                   (p.is_a<c> () && p1.is_a<h> ()))
                 continue;
@@ -1816,6 +1884,17 @@ namespace build2
 
         if (dd.expect (cs) != nullptr)
           l4 ([&]{trace << "linker mismatch forcing update of " << t;});
+
+        // Then the checksum of the linker selected with config.bin.ld.kind,
+        // if any, since it is not incorporated into the compiler checksum.
+        //
+        const char* lcs (
+          !ld_checksum.empty ()
+          ? ld_checksum.c_str ()
+          : "e3b0c44298fc1c149afbf4c8996fb92427ae41e4649b934ca495991b7852b855");
+
+        if (dd.expect (lcs) != nullptr)
+          l4 ([&]{trace << "ld kind mismatch forcing update of " << t;});
       }
 
       // Next check the target. While it might be incorporated into the linker
@@ -1853,7 +1932,10 @@ namespace build2
           //
           arg1 = ranlib ? "rc" : "rcs";
 
-          // For utility libraries use thin archives if possible.
+          // For utility libraries use thin archives if possible. The same
+          // for static libraries that are not installed if requested with
+          // bin.liba.thin. Such libraries are only used by this build so
+          // there is no reason to copy the object files.
           //
           // Thin archives are supported by GNU ar since binutils 2.19.1 and
           // LLVM ar since LLVM 3.8.0. Note that strictly speaking thin
@@ -1861,7 +1943,19 @@ namespace build2
           // probably safe to assume that the two came from the same version
           // of binutils/LLVM.
           //
-          if (lt.utility)
+          // Note that the archive flags are part of the options checksum so
+          // switching between thin and normal archives (for example, when
+          // updating for install) causes the archive to be recreated.
+          //
+          bool thin (lt.utility);
+
+          if (!thin && !for_install && cast_false<bool> (t["bin.liba.thin"]))
+          {
+            const path* ip (cast_null<path> (t["install"]));
+            thin = (ip == nullptr || ip->string () == "false");
+          }
+
+          if (thin)
           {
             const string& id (cast<string> (rs["bin.ar.id"]));
 
@@ -1900,6 +1994,13 @@ namespace build2
           append_options (args, t, c_coptions);
           append_options (args, t, x_coptions);
           append_options (args, tstd);
+          append_options (args, tld);
+
+          // Compress the debug sections in the output (the compiler driver
+          // passes this on to the linker).
+          //
+          if (compress_debug (t))
+            args.push_back ("-gz");
         }
 
         append_options (args, t, c_loptions);
@@ -2307,9 +2408,7 @@ namespace build2
 
       // Append input files noticing the position of the first.
       //
-#ifdef _WIN32
       size_t args_input (args.size ());
-#endif
 
       // The same logic as during hashing above. See also a similar loop
       // inside append_libraries().
@@ -2443,106 +2542,55 @@ namespace build2
       // the "logical" command line while at level 2 and above -- what we are
       // actually executing.
       //
-      // On Windows we need to deal with the command line length limit. The
-      // best workaround seems to be passing (part of) the command line in an
-      // "options file" ("response file" in Microsoft's terminology). Both
-      // Microsoft's link.exe/lib.exe as well as GNU g??.exe/ar.exe support
-      // the same @<file> notation (and with a compatible subset of the
-      // content format; see below). Note also that GCC is smart enough to use
-      // an options file to call the underlying linker if we called it with
-      // @<file>. We will also assume that any other linker that we might be
-      // using supports this notation.
-      //
-      // Note that this is a limitation of the host platform, not the target
-      // (and Wine, where these lines are a bit blurred, does not have this
-      // length limitation).
+      // We also need to deal with the command line length limit, which is
+      // fairly low on Windows. And on other platforms linking something
+      // with tens of thousands of object files produces a command line that
+      // is expensive to pass around (and to print). The best workaround
+      // seems to be passing (part of) the command line in an "options file"
+      // ("response file" in Microsoft's terminology). Microsoft's
+      // link.exe/lib.exe, GNU/LLVM ar, as well as GCC and Clang drivers
+      // support the same @<file> notation (and with a compatible subset of
+      // the content format; see rspfile()). Note also that GCC is smart
+      // enough to use an options file to call the underlying linker if we
+      // called it with @<file>. We will also assume that any other linker
+      // that we might be using supports this notation. Not so for
+      // archivers, however: BSD ar, for example, doesn't.
+      //
+      // Note that on Windows this is a limitation of the host platform, not
+      // the target (and Wine, where these lines are a bit blurred, does not
+      // have this length limitation).
       //
-#ifdef _WIN32
       auto_rmfile trm;
       string targ;
       {
-        // Calculate the would-be command line length similar to how process'
-        // implementation does it.
-        //
-        auto quote = [s = string ()] (const char* a) mutable -> const char*
-        {
-          return process::quote_argument (a, s);
-        };
+        bool rsp (true);
 
-        size_t n (0);
-        for (const char* a: args)
+#ifndef _WIN32
+        if (lt.static_library ())
         {
-          if (a != nullptr)
-          {
-            if (n != 0)
-              n++; // For the space separator.
-
-            n += strlen (quote (a));
-          }
+          const string& id (cast<string> (rs["bin.ar.id"]));
+          rsp = (id == "gnu" || id == "llvm" || id == "msvc");
         }
+#endif
 
-        if (n > 32766) // 32768 - "Unicode terminating null character".
-        {
-          // Use the .t extension (for "temporary").
-          //
-          const path& f ((trm = auto_rmfile (relt + ".t")).path);
-
-          try
-          {
-            ofdstream ofs (f);
-
-            // Both Microsoft and GNU support a space-separated list of
-            // potentially-quoted arguments. GNU also supports backslash-
-            // escaping (whether Microsoft supports it is unclear; but it
-            // definitely doesn't need it for backslashes themselves, for
-            // example, in paths).
-            //
-            bool e (tsys != "win32-msvc"); // Assume GNU if not MSVC.
-            string b;
-
-            for (size_t i (args_input), n (args.size () - 1); i != n; ++i)
-            {
-              const char* a (args[i]);
-
-              if (e) // We will most likely have backslashes so just do it.
-              {
-                for (b.clear (); *a != '\0'; ++a)
-                {
-                  if (*a != '\\')
-                    b += *a;
-                  else
-                    b += "\\\\";
-                }
-
-                a = b.c_str ();
-              }
-
-              ofs << (i != args_input ? " " : "") << quote (a);
-            }
-
-            ofs << '\n';
-            ofs.close ();
-          }
-          catch (const io_error& e)
-          {
-            fail << "unable to write " << f << ": " << e;
-          }
-
-          // Replace input arguments with @file.
-          //
-          targ = '@' + f.string ();
-          args.resize (args_input);
-          args.push_back (targ.c_str());
-          args.push_back (nullptr);
-
-          //@@ TODO: leave .t file if linker failed and verb > 2?
-        }
+        //@@ TODO: leave .t file if linker failed and verb > 2?
+        //
+        if (rsp)
+          rspfile (args,
+                   args_input,
+                   relt + ".t", // Use the .t extension (for "temporary").
+                   tsys == "win32-msvc", // Assume GNU if not MSVC.
+                   trm,
+                   targ);
       }
-#endif
 
       if (verb > 2)
         print_process (args);
 
+      // Time the linker (and any post-link steps) for the statistics.
+      //
+      timestamp ls (system_clock::now ());
+
       try
       {
         // VC tools (both lib.exe and link.exe) send diagnostics to stdout.
@@ -2593,9 +2641,7 @@ namespace build2
         if (e.child)
         {
           rm.cancel ();
-#ifdef _WIN32
           trm.cancel ();
-#endif
           exit (1);
         }
 
@@ -2699,6 +2745,38 @@ namespace build2
         touch (tp, false /* create */, verb_never);
       }
 
+      // Package the .dwo files of the object files that we have linked into
+      // .dwp. The dwp tool finds them via the references in the output so
+      // we don't need to list them.
+      //
+      if (const file* dp = find_adhoc_member<cc::dwp> (t))
+      {
+        const path& dt (dp->path ());
+        const process_path pp (run_search (cast<path> (t[c_dwp]), true));
+
+        path reld (relative (dt));
+        const char* args[] = {
+          pp.recall_string (),
+          "-e", relt.string ().c_str (),
+          "-o", reld.string ().c_str (),
+          nullptr};
+
+        if (verb >= 2)
+          print_process (args);
+
+        // Remove a stale package if this fails.
+        //
+        auto_rmfile drm (dt);
+        run (pp, args);
+        drm.cancel ();
+      }
+
+      stat_link_msec.fetch_add (
+        static_cast<size_t> (
+          std::chrono::duration_cast<std::chrono::milliseconds> (
+            system_clock::now () - ls).count ()),
+        memory_order_relaxed);
+
       rm.cancel ();
       dd.check_mtime (tp);
 
@@ -2716,8 +2794,13 @@ namespace build2
       const file& t (xt.as<file> ());
       ltype lt (link_type (t));
 
-      //@@ TODO add .t to clean if _WIN32 (currently that would be just too
-      //   messy).
+      // Unity build batches directory (see unity_partition()).
+      //
+      string ud;
+      if (cast_false<bool> (t[x_unity]))
+        ud = unity_dir (t).representation ();
+
+      //@@ TODO add .t to clean (currently that would be just too messy).
 
       if (lt.executable ())
       {
@@ -2725,13 +2808,13 @@ namespace build2
         {
           if (tsys == "mingw32")
             return clean_extra (
-              a, t, {".d", ".dlls/", ".manifest.o", ".manifest"});
+              a, t, {".d", ".dlls/", ".manifest.o", ".manifest", ud.c_str ()});
           else
             // Assuming it's VC or alike. Clean up .ilk in case the user
             // enabled incremental linking (note that .ilk replaces .exe).
             //
             return clean_extra (
-              a, t, {".d", ".dlls/", ".manifest", "-.ilk"});
+              a, t, {".d", ".dlls/", ".manifest", "-.ilk", ud.c_str ()});
         }
         // For other platforms it's the defaults.
       }
@@ -2752,7 +2835,8 @@ namespace build2
             // versioning their bases may not be the same.
             //
             if (tsys != "mingw32")
-              return clean_extra (a, t, {{".d", "-.ilk"}, {"-.exp"}});
+              return clean_extra (
+                a, t, {{".d", "-.ilk", ud.c_str ()}, {"-.exp"}});
           }
           else
           {
@@ -2764,13 +2848,14 @@ namespace build2
             return clean_extra (a, t, {".d",
                   paths.link.string ().c_str (),
                   paths.soname.string ().c_str (),
-                  paths.interm.string ().c_str ()});
+                  paths.interm.string ().c_str (),
+                  ud.c_str ()});
           }
         }
         // For static library it's the defaults.
       }
 
-      return clean_extra (a, t, {".d"});
+      return clean_extra (a, t, {".d", ud.c_str ()});
     }
   }
 }
@@ -154,6 +154,31 @@ namespace build2
       pair<path, bool>
       windows_manifest (const file&, bool rpath_assembly) const;
 
+      // Unity build (unity.cxx).
+      //
+      struct unity_batch
+      {
+        const file&   src; // Generated batch source.
+        const target& obj; // Batch object file.
+      };
+
+      struct unity_batches
+      {
+        // Batch index plus one for each prerequisite (in the
+        // group_prerequisite_members() order) or 0 if the prerequisite is
+        // not batched.
+        //
+        vector<size_t>      members;
+        vector<unity_batch> batches;
+        vector<bool>        seen;    // Batch object added (see apply()).
+      };
+
+      static dir_path
+      unity_dir (const target&);
+
+      unity_batches
+      unity_partition (action, const file&, const compile_target_types&) const;
+
       // pkg-config's .pc file generation (pkgconfig.cxx).
       //
       void
@@ -9,14 +9,17 @@
 #include <build2/scope.hxx>
 #include <build2/context.hxx>
 #include <build2/diagnostics.hxx>
+#include <build2/probe-cache.hxx>
 
 #include <build2/bin/target.hxx>
 
-#include <build2/cc/target.hxx> // pc*
+#include <build2/cc/target.hxx> // pc*, pch*, dwo, dwp
 
 #include <build2/config/utility.hxx>
 #include <build2/install/utility.hxx>
 
+#include <build2/bin/guess.hxx> // guess_ld_kind()
+
 #include <build2/cc/guess.hxx>
 
 using namespace std;
@@ -127,7 +130,8 @@ namespace build2
         cast_null<strings> (rs[config_c_coptions]),
         cast_null<strings> (rs[config_x_coptions]),
         cast_null<strings> (rs[config_c_loptions]),
-        cast_null<strings> (rs[config_x_loptions]));
+        cast_null<strings> (rs[config_x_loptions]),
+        rs.out_path ());
 
       const compiler_info& ci (*ci_);
 
@@ -300,8 +304,63 @@ namespace build2
       {
       case compiler_class::gcc:
         {
-          lib_dirs = gcc_library_search_paths (ci.path, rs);
-          inc_dirs = gcc_header_search_paths (ci.path, rs);
+          // Extracting these means running the compiler twice so we keep
+          // them in the probe cache (see probe-cache.hxx for details). The
+          // key includes the compiler checksum and all the options that we
+          // pass. The data is the library directories followed by the
+          // header directories, each prefixed with 'L' or 'I', respectively.
+          //
+          const char* kind ("cc.sys-dirs-1");
+          string key;
+          {
+            sha256 cs;
+            cs.append (static_cast<size_t> (x_lang));
+            cs.append (ci.checksum);
+            hash_options (cs, rs, c_coptions);
+            hash_options (cs, rs, x_coptions);
+            hash_options (cs, tstd);
+            hash_options (cs, rs, c_loptions);
+            hash_options (cs, rs, x_loptions);
+
+            key = compiler_probe_key (kind, ci.path, cs.string ());
+          }
+
+          if (optional<strings> d = probe_load (rs.out_path (), kind, key))
+          {
+            try
+            {
+              for (const string& l: *d)
+              {
+                if (l.size () < 2 || (l[0] != 'L' && l[0] != 'I'))
+                  throw invalid_path (l);
+
+                dir_path dp (l, 1, l.size () - 1);
+
+                if (l[0] == 'L')
+                  lib_dirs.push_back (move (dp));
+                else
+                  inc_dirs.push_back (move (dp));
+              }
+            }
+            catch (const invalid_path&)
+            {
+              lib_dirs.clear ();
+              inc_dirs.clear ();
+            }
+          }
+
+          if (lib_dirs.empty () || inc_dirs.empty ())
+          {
+            lib_dirs = gcc_library_search_paths (ci.path, rs);
+            inc_dirs = gcc_header_search_paths (ci.path, rs);
+
+            strings d;
+            for (const dir_path& p: lib_dirs) d.push_back ('L' + p.string ());
+            for (const dir_path& p: inc_dirs) d.push_back ('I' + p.string ());
+
+            probe_save (rs.out_path (), kind, key, d);
+          }
+
           break;
         }
       case compiler_class::msvc:
@@ -355,6 +414,31 @@ namespace build2
       }
 #endif
 
+      // Select the linker (config.bin.ld.kind) for GCC and Clang targeting
+      // ELF where we link via the compiler driver and have a choice of
+      // linkers (elsewhere the platform linker is used as is). Passing the
+      // -fuse-ld= option ourselves keeps it out of the user's *.loptions.
+      //
+      string ld_kind;
+      if ((ci.id.type == compiler_type::gcc ||
+           ci.id.type == compiler_type::clang) &&
+          (tt.class_ == "linux" || tt.class_ == "bsd"))
+      {
+        auto p (config::required (rs, "config.bin.ld.kind", "auto"));
+
+        bin::ld_kind_info li (
+          bin::guess_ld_kind (ci.path,
+                              cast<string> (p.first),
+                              rs.out_path ()));
+
+        if (!li.kind.empty ())
+        {
+          tld.push_back ("-fuse-ld=" + li.kind);
+          ld_kind = move (li.kind);
+          ld_checksum = move (li.checksum);
+        }
+      }
+
       // If this is a new value (e.g., we are configuring), then print the
       // report at verbosity level 2 and up (-v).
       //
@@ -405,6 +489,11 @@ namespace build2
           dr << "\n  pattern    " << ci.pattern;
         }
 
+        if (!ld_kind.empty ())
+        {
+          dr << "\n  ld kind    " << ld_kind;
+        }
+
         if (verb >= 3 && !inc_dirs.empty ())
         {
           dr << "\n  inc dirs";
@@ -513,8 +602,22 @@ namespace build2
         t.insert<pca> ();
         t.insert<pcs> ();
 
+        t.insert<pch>  ();
+        t.insert<pche> ();
+        t.insert<pcha> ();
+        t.insert<pchs> ();
+
+        t.insert<dwo> ();
+        t.insert<dwp> ();
+
+        // Note that dwp{} is installed next to the executable or library it
+        // belongs to (see link_rule::apply()).
+        //
         if (install_loaded)
+        {
           install_path<pc> (rs, dir_path ("pkgconfig"));
+          install_mode<dwp> (rs, "644");
+        }
       }
 
       // Register rules.
@@ -542,6 +645,18 @@ namespace build2
         r.insert<objs> (perform_clean_id,    x_compile, cr);
         r.insert<objs> (configure_update_id, x_compile, cr);
 
+        r.insert<pche> (perform_update_id,    x_compile, cr);
+        r.insert<pche> (perform_clean_id,     x_compile, cr);
+        r.insert<pche> (configure_update_id,  x_compile, cr);
+
+        r.insert<pcha> (perform_update_id,    x_compile, cr);
+        r.insert<pcha> (perform_clean_id,     x_compile, cr);
+        r.insert<pcha> (configure_update_id,  x_compile, cr);
+
+        r.insert<pchs> (perform_update_id,   x_compile, cr);
+        r.insert<pchs> (perform_clean_id,    x_compile, cr);
+        r.insert<pchs> (configure_update_id, x_compile, cr);
+
         if (modules)
         {
           r.insert<bmie> (perform_update_id,    x_compile, cr);
@@ -49,6 +49,8 @@ namespace build2
       translate_std (const compiler_info&, scope&, const string*) const = 0;
 
       strings tstd;
+      strings tld;               // Linker selection option (-fuse-ld=).
+      string ld_checksum;        // Selected linker checksum (see tld).
       size_t sys_lib_dirs_extra; // First extra path (size if none).
       size_t sys_inc_dirs_extra; // First extra path (size if none).
 
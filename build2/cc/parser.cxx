@@ -16,11 +16,14 @@ namespace build2
     using type = token_type;
 
     translation_unit parser::
-    parse (ifdstream& is, const path& name)
+    parse (ifdstream& is, const path& name, bool lines)
     {
-      lexer l (is, name);
+      lexer l (is, name, lines);
       l_ = &l;
 
+      lines_ = lines;
+      builtin_line_ = false;
+
       translation_unit u;
       u_ = &u;
 
@@ -66,12 +69,25 @@ namespace build2
             //
             //           module                              ;
             // [export]  import <module-name> [<attributes>] ;
+            // [export]  import <header-name> [<attributes>] ;
             // [export]  module <module-name> [<attributes>] ;
             //  export { import <module-name> [<attributes>] ; }
             //  extern   module ...
             //
             const string& id (t.value);
 
+            // Without line numbers in the checksum we have to watch out for
+            // the builtins that expand to the current line (used, for
+            // example, by std::source_location).
+            //
+            if (!lines_                                   &&
+                !builtin_line_                            &&
+                id.compare (0, 10, "__builtin_") == 0     &&
+                (id == "__builtin_LINE"   ||
+                 id == "__builtin_COLUMN" ||
+                 id == "__builtin_source_location"))
+              builtin_line_ = true;
+
             if (bb == 0)
             {
               if      (id == "import")
@@ -126,7 +142,12 @@ namespace build2
         fail (*module_marker_) << "module declaration expected after "
                                << "leading module marker";
 
-      checksum = l.checksum ();
+      // If the translation unit depends on line numbers that we haven't
+      // hashed, then the checksum cannot be relied upon.
+      //
+      if (!builtin_line_)
+        checksum = l.checksum ();
+
       return u;
     }
 
@@ -136,8 +157,20 @@ namespace build2
       // enter: import keyword
       // leave: semi
 
-      l_->next (t); // Start of name.
-      string n (parse_module_name (t));
+      // Start of name. The header-name can be in either form (see
+      // import_type for how it is represented).
+      //
+      import_type ut (import_type::module_intf);
+      string n;
+
+      if (l_->next_header (t) == type::header_name)
+      {
+        ut = import_type::module_header;
+        n = move (t.value);
+        l_->next (t);
+      }
+      else
+        n = parse_module_name (t);
 
       // Should be {}-balanced.
       //
@@ -152,13 +185,13 @@ namespace build2
       auto& is (u_->mod.imports);
 
       auto i (find_if (is.begin (), is.end (),
-                       [&n] (const module_import& i)
+                       [ut, &n] (const module_import& i)
                        {
-                         return i.name == n;
+                         return i.type == ut && i.name == n;
                        }));
 
       if (i == is.end ())
-        is.push_back (module_import {move (n), ex, 0});
+        is.push_back (module_import {ut, move (n), ex, 0});
       else
         i->exported = i->exported || ex;
     }
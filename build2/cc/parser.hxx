@@ -24,8 +24,11 @@ namespace build2
     class parser
     {
     public:
+      // If lines is false, then the token line numbers are not included into
+      // the checksum (see lexer for details).
+      //
       translation_unit
-      parse (ifdstream&, const path& name);
+      parse (ifdstream&, const path& name, bool lines = true);
 
     private:
       void
@@ -45,6 +48,9 @@ namespace build2
       translation_unit* u_;
 
       optional<location> module_marker_;
+
+      bool lines_;
+      bool builtin_line_; // Seen __builtin_LINE() or alike.
     };
   }
 }
@@ -0,0 +1,295 @@
+// file      : build2/cc/pkgconfig-reader.cxx -*- C++ -*-
+// copyright : Copyright (c) 2014-2019 Code Synthesis Ltd
+// license   : MIT; see accompanying LICENSE file
+
+#include <build2/cc/pkgconfig-reader.hxx>
+
+#include <set>
+#include <cstring> // memchr(), strpbrk()
+
+using namespace std;
+using namespace butl;
+
+namespace build2
+{
+  namespace cc
+  {
+    // Expand variable references in [b, e) appending the result to r.
+    // Return false if there is an unsupported construct.
+    //
+    static bool
+    expand (const map<string, string>& vars,
+            const char* b, const char* e,
+            string& r)
+    {
+      for (const char* p (b); p != e; )
+      {
+        const char* d (p);
+        for (; d != e && *d != '$'; ++d) ;
+
+        r.append (p, d - p);
+
+        if (d == e)
+          break;
+
+        // Only ${<name>} ($$ and friends are libpkgconf's business).
+        //
+        if (++d == e || *d != '{')
+          return false;
+
+        const char* n (++d);
+        for (; d != e && *d != '}'; ++d) ;
+
+        if (d == e)
+          return false;
+
+        auto i (vars.find (string (n, d - n)));
+        if (i == vars.end ())
+          return false;
+
+        r += i->second;
+        p = d + 1;
+      }
+
+      return true;
+    }
+
+    // Split the value into arguments. Return false if there is an
+    // unsupported construct.
+    //
+    static bool
+    split (const string& v, strings& r)
+    {
+      string a;
+      bool t (false); // Have argument.
+
+      for (size_t i (0), n (v.size ()); i != n; ++i)
+      {
+        char c (v[i]);
+
+        switch (c)
+        {
+        case ' ':
+        case '\t':
+          {
+            if (t)
+            {
+              r.push_back (move (a));
+              a.clear ();
+              t = false;
+            }
+            continue;
+          }
+        case '"':
+        case '\'':
+          return false;
+        case '\\':
+          {
+            if (++i == n)
+              return false;
+
+            c = v[i];
+            break;
+          }
+        }
+
+        a += c;
+        t = true;
+      }
+
+      if (t)
+        r.push_back (move (a));
+
+      return true;
+    }
+
+    // Return false if any of the arguments (taken together) would be
+    // treated specially by libpkgconf.
+    //
+    static bool
+    plain (const strings& x, const strings& y)
+    {
+      set<string> s;
+
+      for (const strings* v: {&x, &y})
+      {
+        for (const string& a: *v)
+        {
+          // Options separated from their values (-I <dir>) or grouped with
+          // the following argument.
+          //
+          if ((a.size () == 2 && a[0] == '-') ||
+              a == "-framework"               ||
+              a == "-isystem"                 ||
+              a == "-idirafter"               ||
+              a == "-include"                 ||
+              a == "-Wl,--start-group")
+            return false;
+
+          // Duplicates.
+          //
+          if (!s.insert (a).second)
+            return false;
+        }
+      }
+
+      return true;
+    }
+
+    optional<pkgconfig_file>
+    pkgconfig_read (const path& f)
+    {
+      string s;
+      {
+        ifdstream ifs (f);
+        s = ifs.read_text ();
+      }
+
+      pkgconfig_file r;
+
+      // Define pcfiledir similar to libpkgconf unless it would need some
+      // escaping or translation (in which case references to it will be
+      // unsupported).
+      //
+      {
+        string d (f.directory ().string ());
+
+        if (!d.empty () && strpbrk (d.c_str (), " \t\\\"'$#") == nullptr)
+          r.variables.emplace ("pcfiledir", d);
+      }
+
+      // Note that we only expand the fields that we are interested in.
+      //
+      bool cf (false), cfp (false), lf (false), lfp (false);
+      bool rq (false), rqp (false);
+
+      const char* p (s.c_str ());
+      const char* e (p + s.size ());
+
+      for (const char* le; p != e; p = (le != e ? le + 1 : e))
+      {
+        // Find the end of the line and trim the whitespaces (including
+        // CR).
+        //
+        le = p;
+        for (; le != e && *le != '\n'; ++le) ;
+
+        const char* b (p);
+        const char* ee (le);
+
+        for (; b != ee && (*b == ' ' || *b == '\t'); ++b) ;
+        for (;
+             ee != b && (ee[-1] == ' ' || ee[-1] == '\t' || ee[-1] == '\r');
+             --ee) ;
+
+        if (b == ee || *b == '#') // Blank or comment.
+          continue;
+
+        // Line continuation or trailing comment.
+        //
+        if (ee[-1] == '\\' || memchr (b, '#', ee - b) != nullptr)
+          return nullopt;
+
+        // Name followed by '=' (variable) or ':' (field).
+        //
+        const char* n (b);
+        for (;
+             n != ee && (alnum (*n) || *n == '_' || *n == '.');
+             ++n) ;
+
+        if (n == b)
+          return nullopt;
+
+        string k (b, n - b);
+
+        for (; n != ee && (*n == ' ' || *n == '\t'); ++n) ;
+
+        if (n == ee || (*n != '=' && *n != ':'))
+          return nullopt;
+
+        bool var (*n == '=');
+
+        for (++n; n != ee && (*n == ' ' || *n == '\t'); ++n) ;
+
+        if (var)
+        {
+          string v;
+          if (!expand (r.variables, n, ee, v))
+            return nullopt;
+
+          if (!r.variables.emplace (move (k), move (v)).second)
+            return nullopt; // Redefinition (including pcfiledir).
+
+          continue;
+        }
+
+        // Map the field to its value and "seen" flag. Treat the keys that
+        // differ from the ones we know only in case as unsupported.
+        //
+        strings* fs (nullptr);
+        string* fv (nullptr);
+        bool* fd (nullptr);
+
+        if (k == "Cflags" || k == "CFlags")
+        {
+          fs = &r.cflags;
+          fd = &cf;
+        }
+        else if (k == "Cflags.private" || k == "CFlags.private")
+        {
+          fs = &r.cflags_private;
+          fd = &cfp;
+        }
+        else if (k == "Libs")
+        {
+          fs = &r.libs;
+          fd = &lf;
+        }
+        else if (k == "Libs.private")
+        {
+          fs = &r.libs_private;
+          fd = &lfp;
+        }
+        else if (k == "Requires")
+        {
+          fv = &r.requires;
+          fd = &rq;
+        }
+        else if (k == "Requires.private")
+        {
+          fv = &r.requires_private;
+          fd = &rqp;
+        }
+        else if (casecmp (k, "cflags")           == 0 ||
+                 casecmp (k, "cflags.private")   == 0 ||
+                 casecmp (k, "libs")             == 0 ||
+                 casecmp (k, "libs.private")     == 0 ||
+                 casecmp (k, "requires")         == 0 ||
+                 casecmp (k, "requires.private") == 0)
+          return nullopt;
+        else
+          continue; // Name, Description, Version, etc.
+
+        if (*fd)
+          return nullopt; // Repeated field.
+
+        *fd = true;
+
+        string v;
+        if (!expand (r.variables, n, ee, v))
+          return nullopt;
+
+        if (fv != nullptr)
+          *fv = move (v);
+        else if (!split (v, *fs))
+          return nullopt;
+      }
+
+      if (!plain (r.cflags, r.cflags_private) ||
+          !plain (r.libs, r.libs_private))
+        return nullopt;
+
+      return r;
+    }
+  }
+}
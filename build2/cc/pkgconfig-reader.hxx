@@ -0,0 +1,65 @@
+// file      : build2/cc/pkgconfig-reader.hxx -*- C++ -*-
+// copyright : Copyright (c) 2014-2019 Code Synthesis Ltd
+// license   : MIT; see accompanying LICENSE file
+
+#ifndef BUILD2_CC_PKGCONFIG_READER_HXX
+#define BUILD2_CC_PKGCONFIG_READER_HXX
+
+#include <map>
+
+#include <build2/types.hxx>
+#include <build2/utility.hxx>
+
+namespace build2
+{
+  namespace cc
+  {
+    // Native .pc file reader.
+    //
+    // Loading a .pc file with libpkgconf involves setting up a client with
+    // its personality as well as search and fragment lists, which is a lot
+    // of machinery compared to what most .pc files contain (for example,
+    // those generated by pkgconfig_save()). This reader handles the subset
+    // of the format that such files use and reports anything else as
+    // unsupported, in which case the caller should fall back to libpkgconf.
+    //
+    // Specifically, supported are comment and blank lines, variable
+    // definitions (<name>=<value>) that only reference previously defined
+    // variables or pcfiledir (${<name>}), and fields (<Key>: <value>) of
+    // which Cflags, Cflags.private, Libs, Libs.private, Requires, and
+    // Requires.private are extracted (the rest is ignored). The flag values
+    // are split into arguments on whitespace with backslash escaping.
+    //
+    // Not supported are line continuations, trailing comments, quoting,
+    // references to undefined (including other built-in) variables,
+    // repeated variables or fields, as well as arguments that libpkgconf
+    // would treat specially: options separated from their values (-I
+    // <dir>), those that are grouped with the following argument (-isystem,
+    // -framework, etc), and duplicates (which libpkgconf merges).
+    //
+    // Note that Requires and Requires.private are returned as is and it is
+    // up to the caller to decide whether it can handle them (for example,
+    // resolving the dependencies is not something this reader does).
+    //
+    struct pkgconfig_file
+    {
+      std::map<string, string> variables; // Including pcfiledir.
+
+      strings cflags;
+      strings cflags_private;
+      strings libs;
+      strings libs_private;
+
+      string requires;
+      string requires_private;
+    };
+
+    // Return nullopt if the file uses an unsupported construct. Throw
+    // io_error if unable to read the file.
+    //
+    optional<pkgconfig_file>
+    pkgconfig_read (const path&);
+  }
+}
+
+#endif // BUILD2_CC_PKGCONFIG_READER_HXX
@@ -9,6 +9,11 @@
 #  include <libpkgconf/libpkgconf.h>
 #endif
 
+#include <map>
+#include <cstdlib>  // strtoull()
+#include <cstring>  // strncmp()
+#include <iterator> // make_move_iterator()
+
 #include <build2/scope.hxx>
 #include <build2/target.hxx>
 #include <build2/context.hxx>
@@ -16,6 +21,7 @@
 #include <build2/algorithm.hxx>
 #include <build2/filesystem.hxx>
 #include <build2/diagnostics.hxx>
+#include <build2/probe-cache.hxx>
 
 #include <build2/install/utility.hxx>
 
@@ -26,6 +32,7 @@
 #include <build2/cc/utility.hxx>
 
 #include <build2/cc/common.hxx>
+#include <build2/cc/pkgconfig-reader.hxx>
 #include <build2/cc/compile-rule.hxx>
 #include <build2/cc/link-rule.hxx>
 
@@ -89,11 +96,18 @@ namespace build2
     path_type path;
 
   public:
+    // If the cache root directory is not empty, then first try to load the
+    // package information from the persistent cache (see below). Failed
+    // that, read the file with the native reader if it can handle it (see
+    // pkgconfig-reader.hxx) and only load the package with libpkgconf
+    // otherwise (or if we are asked something that wasn't cached).
+    //
     explicit
     pkgconf (path_type,
              const dir_paths& pc_dirs,
+             const dir_paths& sys_lib_dirs,
              const dir_paths& sys_inc_dirs,
-             const dir_paths& sys_lib_dirs);
+             const dir_path& cache_root = dir_path ());
 
     // Create a special empty object. Querying package information on such
     // an object is illegal.
@@ -106,9 +120,18 @@ namespace build2
     //
     pkgconf (pkgconf&& p)
         : path (move (p.path)),
+          pc_dirs_ (move (p.pc_dirs_)),
+          sys_lib_dirs_ (move (p.sys_lib_dirs_)),
+          sys_inc_dirs_ (move (p.sys_inc_dirs_)),
+          cache_root_ (move (p.cache_root_)),
+          cache_key_ (move (p.cache_key_)),
+          cache_ (move (p.cache_)),
+          cache_dirty_ (p.cache_dirty_),
+          native_ (move (p.native_)),
           client_ (p.client_),
           pkg_ (p.pkg_)
     {
+      p.cache_dirty_ = false;
       p.client_ = nullptr;
       p.pkg_ = nullptr;
     }
@@ -139,22 +162,72 @@ namespace build2
     string
     variable (const string& s) const {return variable (s.c_str ());}
 
+    // Save the query results to the persistent cache if anything new was
+    // queried.
+    //
+    void
+    save () const;
+
+  private:
+    // Create the client and load the package, if not already done.
+    //
+    void
+    load () const;
+
+    const strings*
+    cached (const string& query) const;
+
+    strings
+    cache (string query, strings result) const;
+
   private:
+    dir_paths pc_dirs_;
+    dir_paths sys_lib_dirs_;
+    dir_paths sys_inc_dirs_;
+
+    dir_path                               cache_root_;
+    string                                 cache_key_; // Empty if no cache.
+    mutable std::map<string, strings>      cache_;     // Query results.
+    mutable bool                           cache_dirty_ = false;
+
+    optional<cc::pkgconfig_file> native_;
+
     // Keep them as raw pointers not to deal with API thread-unsafety in
     // deleters and introducing additional mutex locks.
     //
-    pkgconf_client_t* client_ = nullptr;
-    pkgconf_pkg_t* pkg_ = nullptr;
+    mutable pkgconf_client_t* client_ = nullptr;
+    mutable pkgconf_pkg_t* pkg_ = nullptr;
   };
 
-  // Currently the library is not thread-safe, even on the pkgconf_client_t
-  // level (see issue #128 for details).
+  // Older versions of the library are not thread-safe, even on the
+  // pkgconf_client_t level (see issue #128 for details), and there is no
+  // version macro that we could use to detect this. So by default we
+  // serialize all the library calls.
   //
-  // @@ An update: seems that the obvious thread-safety issues are fixed.
-  //    However, let's keep mutex locking for now not to introduce potential
-  //    issues before we make sure that there are no other ones.
+  // Each pkgconf object, however, has its own pkgconf_client_t instance
+  // which is never shared between threads (see pkgconfig_load()). So when
+  // building against a version where the client-level thread-safety issues
+  // are fixed, BUILD2_PKGCONF_PARALLEL can be defined (for example, with
+  // config.cxx.poptions) to make the calls for different objects
+  // concurrently. Note also that the query results are shared between the
+  // objects so that each package is normally only loaded once (see below).
   //
-  static mutex pkgconf_mutex;
+  struct pkgconf_lock
+  {
+#ifndef BUILD2_PKGCONF_PARALLEL
+    pkgconf_lock (): l_ (mutex_) {}
+
+  private:
+    static mutex mutex_;
+    mlock l_;
+#else
+    pkgconf_lock () {} // Not trivial to suppress unused variable warnings.
+#endif
+  };
+
+#ifndef BUILD2_PKGCONF_PARALLEL
+  mutex pkgconf_lock::mutex_;
+#endif
 
   // The package dependency traversal depth limit.
   //
@@ -279,6 +352,320 @@ namespace build2
     return r;
   }
 
+  // As above but for the natively-read arguments (which are never separated
+  // from their values, see pkgconfig-reader.hxx).
+  //
+  static strings
+  to_strings (const strings& x,
+              const strings* y,
+              char type,
+              const dir_paths& sysdirs)
+  {
+    assert (type == 'I' || type == 'L');
+
+    strings r;
+
+    for (const strings* v: {&x, y})
+    {
+      if (v == nullptr)
+        continue;
+
+      for (const string& a: *v)
+      {
+        if (a.size () > 2 && a[0] == '-' && a[1] == type)
+        try
+        {
+          dir_path d (string (a, 2));
+
+          if (find (sysdirs.begin (), sysdirs.end (), d) != sysdirs.end ())
+            continue;
+        }
+        catch (const invalid_path&) {}
+
+        r.push_back (a);
+      }
+    }
+
+    return r;
+  }
+
+  // Persistent cache of the package information.
+  //
+  // Resolving the package flags involves loading the .pc file and all its
+  // (recursive) dependencies as well as filtering out the system
+  // directories. To avoid doing this on every build system invocation we
+  // cache the query results in the probe cache (see probe-cache.hxx for
+  // details). The key is calculated from the build system version, the .pc
+  // file path, the names and modification times of all the .pc files in the
+  // directories where the file and its dependencies are searched for, the
+  // system directories used for filtering, as well as the pkg-config
+  // environment variables.
+  //
+  static const char* const pkgconf_cache_kind = "cc.pkgconfig-1";
+
+  // The query results are also shared in memory between the pkgconf objects
+  // for the same key (for example, for the static and shared variants of a
+  // library or for the same library imported by several projects). This
+  // way each query is normally made with libpkgconf (and thus, unless
+  // BUILD2_PKGCONF_PARALLEL is defined, under the global lock) only once
+  // per invocation while the subsequent objects only take the (shared) lock
+  // of this map.
+  //
+  static shared_mutex pkgconf_loaded_mutex;
+  static std::map<string, std::map<string, strings>> pkgconf_loaded;
+
+  // Return the checksum of the .pc files (names and modification times) in
+  // the specified directory or empty string if the directory cannot be
+  // examined. The result is calculated once per directory per invocation.
+  //
+  static string
+  pkgconf_dir_checksum (const dir_path& d)
+  {
+    static mutex m;
+    static std::map<dir_path, string> dirs;
+
+    {
+      mlock l (m);
+
+      auto i (dirs.find (d));
+      if (i != dirs.end ())
+        return i->second;
+    }
+
+    string r;
+    try
+    {
+      vector<pair<string, timestamp>> fs;
+
+      if (dir_exists (d))
+      {
+        for (const dir_entry& e: dir_iterator (d, true /* ignore_dangling */))
+        {
+          const path& n (e.path ());
+
+          if (n.extension () == "pc")
+            fs.emplace_back (n.string (), file_mtime (d / n));
+        }
+      }
+
+      sort (fs.begin (), fs.end ());
+
+      sha256 cs;
+      cs.append (static_cast<uint64_t> (fs.size ()));
+
+      for (const pair<string, timestamp>& f: fs)
+      {
+        cs.append (f.first);
+        cs.append (
+          static_cast<uint64_t> (f.second.time_since_epoch ().count ()));
+      }
+
+      r = cs.string ();
+    }
+    catch (const system_error&) {} // Don't cache.
+
+    mlock l (m);
+    return dirs.emplace (d, move (r)).first->second;
+  }
+
+  static string
+  pkgconf_cache_key (const path& p,
+                     const dir_paths& pc_dirs,
+                     const dir_paths& sys_lib_dirs,
+                     const dir_paths& sys_inc_dirs)
+  {
+    sha256 cs;
+    cs.append (pkgconf_cache_kind);
+    cs.append (BUILD2_VERSION_ID);
+    cs.append (p.string ());
+
+    auto dir = [&cs] (const dir_path& d) -> bool
+    {
+      string c (pkgconf_dir_checksum (d));
+
+      if (c.empty ())
+        return false;
+
+      cs.append (d.string ());
+      cs.append (c);
+      return true;
+    };
+
+    if (!dir (p.directory ()))
+      return string ();
+
+    for (const dir_path& d: pc_dirs)
+    {
+      if (!dir (d))
+        return string ();
+    }
+
+    cs.append ('\0');
+    for (const dir_path& d: sys_lib_dirs) cs.append (d.string ());
+
+    cs.append ('\0');
+    for (const dir_path& d: sys_inc_dirs) cs.append (d.string ());
+
+    for (const char* n: {"PKG_CONFIG_SYSROOT_DIR",
+                         "PKG_CONFIG_TOP_BUILD_DIR",
+                         "PKG_CONFIG_ALLOW_SYSTEM_CFLAGS",
+                         "PKG_CONFIG_ALLOW_SYSTEM_LIBS",
+                         "PKG_CONFIG_SYSTEM_INCLUDE_PATH",
+                         "PKG_CONFIG_SYSTEM_LIBRARY_PATH"})
+    {
+      cs.append (n);
+
+      if (optional<string> v = getenv (n))
+      {
+        cs.append ('=');
+        cs.append (*v);
+      }
+      else
+        cs.append ('\0');
+    }
+
+    return cs.string ();
+  }
+
+  pkgconf::
+  pkgconf (path_type p,
+           const dir_paths& pc_dirs,
+           const dir_paths& sys_lib_dirs,
+           const dir_paths& sys_inc_dirs,
+           const dir_path& cache_root)
+      : path (move (p)),
+        pc_dirs_ (pc_dirs),
+        sys_lib_dirs_ (sys_lib_dirs),
+        sys_inc_dirs_ (sys_inc_dirs),
+        cache_root_ (cache_root)
+  {
+    cache_key_ = pkgconf_cache_key (path, pc_dirs, sys_lib_dirs,
+                                    sys_inc_dirs);
+
+    if (!cache_key_.empty ())
+    {
+      // The entry data is a sequence of the query, the result size, and the
+      // result lines.
+      //
+      if (optional<strings> d =
+          !cache_root_.empty ()
+          ? probe_load (cache_root_, pkgconf_cache_kind, cache_key_)
+          : nullopt)
+      {
+        for (auto i (d->begin ()), e (d->end ()); i != e; )
+        {
+          string q (move (*i++));
+
+          size_t n (string::npos);
+          if (i != e)
+            n = static_cast<size_t> (strtoull ((i++)->c_str (), nullptr, 10));
+
+          if (n > static_cast<size_t> (e - i))
+          {
+            cache_.clear (); // Corrupted, treat as a miss.
+            break;
+          }
+
+          strings r (make_move_iterator (i), make_move_iterator (i + n));
+          i += n;
+
+          cache_.emplace (move (q), move (r));
+        }
+
+        if (!cache_.empty ())
+        {
+          ulock l (pkgconf_loaded_mutex);
+          pkgconf_loaded[cache_key_].insert (cache_.begin (), cache_.end ());
+          return;
+        }
+      }
+
+      // Failed that, see if another object has already loaded this package.
+      // If so, we still need to save the results to our persistent cache.
+      //
+      {
+        slock l (pkgconf_loaded_mutex);
+
+        auto i (pkgconf_loaded.find (cache_key_));
+        if (i != pkgconf_loaded.end ())
+          cache_ = i->second;
+      }
+
+      if (!cache_.empty ())
+      {
+        cache_dirty_ = true;
+        return;
+      }
+    }
+
+    // Leave the packages with dependencies as well as sysroot handling to
+    // libpkgconf. And if the file cannot be read, let libpkgconf diagnose
+    // it.
+    //
+    if (!getenv ("PKG_CONFIG_SYSROOT_DIR"))
+    try
+    {
+      if (optional<cc::pkgconfig_file> f = cc::pkgconfig_read (path))
+      {
+        if (f->requires.empty () && f->requires_private.empty ())
+        {
+          native_ = move (f);
+          return;
+        }
+      }
+    }
+    catch (const io_error&) {}
+
+    load ();
+  }
+
+  const strings* pkgconf::
+  cached (const string& q) const
+  {
+    auto i (cache_.find (q));
+    return i != cache_.end () ? &i->second : nullptr;
+  }
+
+  strings pkgconf::
+  cache (string q, strings r) const
+  {
+    if (cache_key_.empty ())
+      return r;
+
+    {
+      ulock l (pkgconf_loaded_mutex);
+      pkgconf_loaded[cache_key_].emplace (q, r);
+    }
+
+    cache_dirty_ = true;
+    return cache_.emplace (move (q), move (r)).first->second;
+  }
+
+  void pkgconf::
+  save () const
+  {
+    if (!cache_dirty_ || cache_root_.empty ())
+      return;
+
+    strings d;
+    for (const auto& p: cache_)
+    {
+      d.push_back (p.first);
+      d.push_back (to_string (p.second.size ()));
+
+      for (const string& l: p.second)
+      {
+        if (l.find ('\n') != string::npos) // Not representable.
+          return;
+
+        d.push_back (l);
+      }
+    }
+
+    probe_save (cache_root_, pkgconf_cache_kind, cache_key_, d);
+    cache_dirty_ = false;
+  }
+
   // Note that some libpkgconf functions can potentially return NULL, failing
   // to allocate the required memory block. However, we will not check the
   // returned value for NULL as the library doesn't do so, prior to filling the
@@ -286,13 +673,12 @@ namespace build2
   // useless. Also, for some functions the NULL result has a special semantics,
   // for example "not found".
   //
-  pkgconf::
-  pkgconf (path_type p,
-           const dir_paths& pc_dirs,
-           const dir_paths& sys_lib_dirs,
-           const dir_paths& sys_inc_dirs)
-      : path (move (p))
+  void pkgconf::
+  load () const
   {
+    if (client_ != nullptr)
+      return;
+
     auto add_dirs = [] (pkgconf_list_t& dir_list,
                         const dir_paths& dirs,
                         bool suppress_dups,
@@ -308,7 +694,7 @@ namespace build2
         pkgconf_path_add (d.string ().c_str (), &dir_list, suppress_dups);
     };
 
-    mlock l (pkgconf_mutex);
+    pkgconf_lock l;
 
     // Initialize the client handle.
     //
@@ -325,12 +711,12 @@ namespace build2
     // We will re-create these lists from scratch.
     //
     add_dirs (c->filter_libdirs,
-              sys_lib_dirs,
+              sys_lib_dirs_,
               false /* suppress_dups */,
               true  /* cleanup */);
 
     add_dirs (c->filter_includedirs,
-              sys_inc_dirs,
+              sys_inc_dirs_,
               false /* suppress_dups */,
               true  /* cleanup */);
 
@@ -347,7 +733,7 @@ namespace build2
     // Add the .pc file search directories.
     //
     assert (c->dir_list.length == 1); // Package file directory (see above).
-    add_dirs (c->dir_list, pc_dirs, true /* suppress_dups */);
+    add_dirs (c->dir_list, pc_dirs_, true /* suppress_dups */);
 
     client_ = c.release ();
   }
@@ -355,11 +741,11 @@ namespace build2
   pkgconf::
   ~pkgconf ()
   {
-    if (client_ != nullptr) // Not empty.
+    if (client_ != nullptr) // Loaded.
     {
       assert (pkg_ != nullptr);
 
-      mlock l (pkgconf_mutex);
+      pkgconf_lock l;
       pkgconf_pkg_unref (client_, pkg_);
       pkgconf_client_free (client_);
     }
@@ -368,9 +754,23 @@ namespace build2
   strings pkgconf::
   cflags (bool stat) const
   {
-    assert (client_ != nullptr); // Must not be empty.
+    assert (!path.empty ()); // Must not be empty.
+
+    string q (stat ? "cflags.static" : "cflags");
+
+    if (const strings* r = cached (q))
+      return *r;
 
-    mlock l (pkgconf_mutex);
+    if (native_)
+      return cache (move (q),
+                    to_strings (native_->cflags,
+                                stat ? &native_->cflags_private : nullptr,
+                                'I',
+                                sys_inc_dirs_));
+
+    load ();
+
+    pkgconf_lock l;
 
     pkgconf_client_set_flags (
       client_,
@@ -396,15 +796,30 @@ namespace build2
       throw failed (); // Assume the diagnostics is issued.
 
     unique_ptr<pkgconf_list_t, fragments_deleter> fd (&f); // Auto-deleter.
-    return to_strings (f, 'I', client_->filter_includedirs);
+    return cache (move (q),
+                  to_strings (f, 'I', client_->filter_includedirs));
   }
 
   strings pkgconf::
   libs (bool stat) const
   {
-    assert (client_ != nullptr); // Must not be empty.
+    assert (!path.empty ()); // Must not be empty.
+
+    string q (stat ? "libs.static" : "libs");
 
-    mlock l (pkgconf_mutex);
+    if (const strings* r = cached (q))
+      return *r;
+
+    if (native_)
+      return cache (move (q),
+                    to_strings (native_->libs,
+                                stat ? &native_->libs_private : nullptr,
+                                'L',
+                                sys_lib_dirs_));
+
+    load ();
+
+    pkgconf_lock l;
 
     pkgconf_client_set_flags (
       client_,
@@ -425,17 +840,46 @@ namespace build2
       throw failed (); // Assume the diagnostics is issued.
 
     unique_ptr<pkgconf_list_t, fragments_deleter> fd (&f); // Auto-deleter.
-    return to_strings (f, 'L', client_->filter_libdirs);
+    return cache (move (q), to_strings (f, 'L', client_->filter_libdirs));
   }
 
   string pkgconf::
   variable (const char* name) const
   {
-    assert (client_ != nullptr); // Must not be empty.
+    assert (!path.empty ()); // Must not be empty.
 
-    mlock l (pkgconf_mutex);
-    const char* r (pkgconf_tuple_find (client_, &pkg_->vars, name));
-    return r != nullptr ? string (r) : string ();
+    string q ("variable.");
+    q += name;
+
+    if (const strings* r = cached (q))
+      return r->empty () ? string () : r->front ();
+
+    // Note that libpkgconf also has the pc_* built-in variables.
+    //
+    string r;
+    if (native_ && strncmp (name, "pc_", 3) != 0)
+    {
+      auto i (native_->variables.find (name));
+      if (i != native_->variables.end ())
+        r = i->second;
+    }
+    else
+    {
+      load ();
+
+      pkgconf_lock l;
+      if (const char* v = pkgconf_tuple_find (client_, &pkg_->vars, name))
+        r = v;
+    }
+
+    // Note: cache an empty value as an empty list.
+    //
+    strings rs;
+    if (!r.empty ())
+      rs.push_back (move (r));
+
+    rs = cache (move (q), move (rs));
+    return rs.empty () ? string () : move (rs.front ());
   }
 
 #endif
@@ -1131,13 +1575,19 @@ namespace build2
       for (const dir_path& d: top_usrd) pkgconfig_search (d, add_pc_dir);
       for (const dir_path& d: top_sysd) pkgconfig_search (d, add_pc_dir);
 
+      // Cache the package information in the importing project's out_root
+      // (see pkgconf for details).
+      //
+      const scope* rs (s.root_scope ());
+      dir_path cr (rs != nullptr ? rs->out_path () : dir_path ());
+
       bool pa (at != nullptr && !ap.empty ());
       if (pa || sp.empty ())
-        apc = pkgconf (ap, pc_dirs, sys_lib_dirs, sys_inc_dirs);
+        apc = pkgconf (ap, pc_dirs, sys_lib_dirs, sys_inc_dirs, cr);
 
       bool ps (st != nullptr && !sp.empty ());
       if (ps || ap.empty ())
-        spc = pkgconf (sp, pc_dirs, sys_lib_dirs, sys_inc_dirs);
+        spc = pkgconf (sp, pc_dirs, sys_lib_dirs, sys_inc_dirs, cr);
 
       // Sort out the interface dependencies (which we are setting on lib{}).
       // If we have the shared .pc variant, then we use that.  Otherwise --
@@ -1179,6 +1629,9 @@ namespace build2
       // file rule won't match.
       //
       lt.mtime (file_mtime (ipc.path));
+
+      if (pa || sp.empty ()) apc.save ();
+      if (ps || ap.empty ()) spc.save ();
     }
 
 #else
@@ -55,6 +55,111 @@ namespace build2
       false
     };
 
+    const target_type pchx::static_type
+    {
+      "pchx",
+      &file::static_type,
+      nullptr,
+      nullptr,
+      nullptr,
+      nullptr,
+      nullptr,
+      &target_search,
+      false
+    };
+
+    // pch*{} member factory (see bin::m_factory() for details).
+    //
+    template <typename M>
+    static target*
+    pch_m_factory (const target_type&, dir_path dir, dir_path out, string n)
+    {
+      const pch* g (targets.find<pch> (dir, out, n));
+
+      M* m (new M (move (dir), move (out), move (n)));
+      m->group = g;
+
+      return m;
+    }
+
+    const target_type pche::static_type
+    {
+      "pche",
+      &pchx::static_type,
+      &pch_m_factory<pche>,
+      nullptr, /* fixed_extension */
+      &target_extension_var<var_extension, nullptr>,
+      &target_pattern_var<var_extension, nullptr>,
+      nullptr,
+      &target_search, // Note: not _file(); don't look for an existing file.
+      false
+    };
+
+    const target_type pcha::static_type
+    {
+      "pcha",
+      &pchx::static_type,
+      &pch_m_factory<pcha>,
+      nullptr, /* fixed_extension */
+      &target_extension_var<var_extension, nullptr>,
+      &target_pattern_var<var_extension, nullptr>,
+      nullptr,
+      &target_search, // Note: not _file(); don't look for an existing file.
+      false
+    };
+
+    const target_type pchs::static_type
+    {
+      "pchs",
+      &pchx::static_type,
+      &pch_m_factory<pchs>,
+      nullptr, /* fixed_extension */
+      &target_extension_var<var_extension, nullptr>,
+      &target_pattern_var<var_extension, nullptr>,
+      nullptr,
+      &target_search, // Note: not _file(); don't look for an existing file.
+      false
+    };
+
+    // pch{} group factory (see bin::g_factory() for details).
+    //
+    static target*
+    pch_g_factory (const target_type&, dir_path dir, dir_path out, string n)
+    {
+      // Casts are MT-aware (during serial load).
+      //
+      pche* e (phase == run_phase::load
+               ? const_cast<pche*> (targets.find<pche> (dir, out, n))
+               : nullptr);
+      pcha* a (phase == run_phase::load
+               ? const_cast<pcha*> (targets.find<pcha> (dir, out, n))
+               : nullptr);
+      pchs* s (phase == run_phase::load
+               ? const_cast<pchs*> (targets.find<pchs> (dir, out, n))
+               : nullptr);
+
+      pch* g (new pch (move (dir), move (out), move (n)));
+
+      if (e != nullptr) e->group = g;
+      if (a != nullptr) a->group = g;
+      if (s != nullptr) s->group = g;
+
+      return g;
+    }
+
+    const target_type pch::static_type
+    {
+      "pch",
+      &target::static_type,
+      &pch_g_factory,
+      nullptr,
+      nullptr,
+      nullptr,
+      nullptr,
+      &target_search,
+      false
+    };
+
     const target_type pc::static_type
     {
       "pc",
@@ -97,5 +202,35 @@ namespace build2
       &file_search,
       false
     };
+
+    extern const char dwo_ext[] = "dwo"; // VC14 rejects constexpr.
+
+    const target_type dwo::static_type
+    {
+      "dwo",
+      &file::static_type,
+      &target_factory<dwo>,
+      &target_extension_fix<dwo_ext>,
+      nullptr, /* default_extension */
+      &target_pattern_fix<dwo_ext>,
+      &target_print_0_ext_verb, // Fixed extension, no use printing.
+      &file_search,
+      false
+    };
+
+    extern const char dwp_ext[] = "dwp"; // VC14 rejects constexpr.
+
+    const target_type dwp::static_type
+    {
+      "dwp",
+      &file::static_type,
+      &target_factory<dwp>,
+      &target_extension_fix<dwp_ext>,
+      nullptr, /* default_extension */
+      &target_pattern_fix<dwp_ext>,
+      &target_print_0_ext_verb, // Fixed extension, no use printing.
+      &file_search,
+      false
+    };
   }
 }
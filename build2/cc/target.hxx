@@ -58,6 +58,71 @@ namespace build2
       virtual const target_type& dynamic_type () const {return static_type;}
     };
 
+    // Precompiled header.
+    //
+    // Similar to obj{} and bmi{}, pch{} is a group with the pche{}, pcha{},
+    // and pchs{} members, each compiled with the options appropriate for the
+    // corresponding object file type. The member is compiled from a single
+    // header prerequisite (hxx{} for C++, h{} for C) and is then used by the
+    // object files that list pch{} (or the corresponding member) as their
+    // prerequisite. For example:
+    //
+    // pch{common}: hxx{common}
+    // exe{hello}: cxx{hello} pch{common}
+    //
+    // The effect is as if the header was force-included (-include) at the
+    // beginning of each such translation unit. Only GCC and Clang are
+    // currently supported.
+    //
+    class pchx: public file // Common base of all pchX{} files.
+    {
+    public:
+      using file::file;
+
+    public:
+      static const target_type static_type;
+    };
+
+    class pche: public pchx
+    {
+    public:
+      using pchx::pchx;
+
+    public:
+      static const target_type static_type;
+      virtual const target_type& dynamic_type () const {return static_type;}
+    };
+
+    class pcha: public pchx
+    {
+    public:
+      using pchx::pchx;
+
+    public:
+      static const target_type static_type;
+      virtual const target_type& dynamic_type () const {return static_type;}
+    };
+
+    class pchs: public pchx
+    {
+    public:
+      using pchx::pchx;
+
+    public:
+      static const target_type static_type;
+      virtual const target_type& dynamic_type () const {return static_type;}
+    };
+
+    class pch: public target
+    {
+    public:
+      using target::target;
+
+    public:
+      static const target_type static_type;
+      virtual const target_type& dynamic_type () const {return static_type;}
+    };
+
     // pkg-config file targets.
     //
     class pc: public file
@@ -88,6 +153,33 @@ namespace build2
       static const target_type static_type;
       virtual const target_type& dynamic_type () const {return static_type;}
     };
+
+    // Split DWARF debug information.
+    //
+    // The dwo{} target is an ad hoc member of obj*{} (or bmi*{}) that is
+    // produced by the compiler with -gsplit-dwarf. The dwp{} target is an ad
+    // hoc member of exe{}/libs{} that is packaged from the dwo{} files of the
+    // object files it was linked from (see cc.split_dwarf and cc.dwp).
+    //
+    class dwo: public file
+    {
+    public:
+      using file::file;
+
+    public:
+      static const target_type static_type;
+      virtual const target_type& dynamic_type () const {return static_type;}
+    };
+
+    class dwp: public file
+    {
+    public:
+      using file::file;
+
+    public:
+      static const target_type static_type;
+      virtual const target_type& dynamic_type () const {return static_type;}
+    };
   }
 }
 
@@ -16,11 +16,19 @@ namespace build2
   {
     // Translation unit information.
     //
+    // For a header unit import the name is the header-name without the
+    // delimiters, except for the <>-form where they are preserved (for
+    // example, <vector>, foo/bar.hxx, /usr/include/stdio.h). Once resolved
+    // (see compile::search_modules()), it is the absolute header path.
+    //
+    enum class import_type {module_intf, module_header};
+
     struct module_import
     {
-      string name;
-      bool   exported; // True if re-exported (export import M;).
-      size_t score;    // See compile::search_modules().
+      import_type type;
+      string      name;
+      bool        exported; // True if re-exported (export import M;).
+      size_t      score;    // See compile::search_modules().
     };
 
     using module_imports = vector<module_import>;
@@ -32,7 +40,12 @@ namespace build2
       module_imports imports;       // Imported modules.
     };
 
-    enum class translation_type {plain, module_iface, module_impl};
+    // Note that module_header (header unit) is never returned by
+    // translation_unit::type() since it is determined by the target type
+    // rather than by the translation unit itself.
+    //
+    enum class translation_type {plain, module_iface, module_impl,
+                                 module_header};
 
     struct translation_unit
     {
@@ -78,6 +91,7 @@ namespace build2
     {
       const target_type& obj;
       const target_type& bmi;
+      const target_type& pch;
     };
 
     // Library link order.
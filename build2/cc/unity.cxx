@@ -0,0 +1,203 @@
+// file      : build2/cc/unity.cxx -*- C++ -*-
+// copyright : Copyright (c) 2014-2019 Code Synthesis Ltd
+// license   : MIT; see accompanying LICENSE file
+
+#include <build2/scope.hxx>
+#include <build2/target.hxx>
+#include <build2/context.hxx>
+#include <build2/variable.hxx>
+#include <build2/algorithm.hxx>
+#include <build2/filesystem.hxx>
+#include <build2/diagnostics.hxx>
+
+#include <build2/cc/link-rule.hxx>
+
+using namespace std;
+using namespace butl;
+
+namespace build2
+{
+  namespace cc
+  {
+    // We keep the batches of each executable/library in a separate
+    // subdirectory, for example, hello.exe.unity/. Note that we cannot use
+    // the target path since it is not yet known when we partition.
+    //
+    dir_path link_rule::
+    unity_dir (const target& t)
+    {
+      return t.out_dir () /
+        dir_path (t.name + '.' + t.type ().name + ".unity");
+    }
+
+    // Partition the x_src{} prerequisites of the target into unity batches.
+    //
+    // Each batch is compiled as a single translation unit from the generated
+    // source file (batch-<N>.<ext> in the unity directory) that #include's
+    // up to x.unity.batch member sources. The members end up as header
+    // dependencies of the batch object file so changing any of them causes
+    // the batch to be recompiled. To keep this stable, the batch source is
+    // only rewritten if its contents have changed.
+    //
+    // Recompiling the whole batch after every edit defeats the purpose of
+    // incremental development. So a member that was modified after the batch
+    // source has been generated is isolated: it is dropped from the batch
+    // and compiled separately (this does change the batch but only once). An
+    // isolated member is recorded in the batch source as a commented-out
+    // #include directive and remains isolated until clean. If, however, the
+    // majority of the batch members have been modified (say, after switching
+    // branches), then we assume it's not an edit and rebatch from scratch.
+    //
+    // A source file that does not (yet) exist (presumably generated) as well
+    // as a source for which x.unity is set to false as a prerequisite-
+    // specific variable are compiled separately.
+    //
+    // Note that the batch sources are only written when performing update.
+    //
+    link_rule::unity_batches link_rule::
+    unity_partition (action a,
+                     const file& t,
+                     const compile_target_types& tt) const
+    {
+      unity_batches r;
+
+      if (!cast_false<bool> (t[x_unity]))
+        return r;
+
+      uint64_t bn (16);
+      if (lookup l = t[x_unity_batch])
+      {
+        if ((bn = cast<uint64_t> (l)) == 0)
+          fail << "invalid " << x_unity_batch.name << " value 0 for " << t;
+      }
+
+      struct member
+      {
+        size_t    index; // Prerequisite index.
+        path      src;   // Source file path.
+        timestamp mt;    // Source file modification time.
+      };
+
+      vector<vector<member>> bs;
+
+      for (prerequisite_member p: group_prerequisite_members (a, t))
+      {
+        size_t i (r.members.size ());
+        r.members.push_back (0);
+
+        if (include (a, t, p) != include_type::normal || !p.is_a (x_src))
+          continue;
+
+        {
+          lookup l (p.prerequisite.vars[x_unity]);
+          if (l && !cast<bool> (l))
+            continue;
+        }
+
+        const file* f (p.search (t).is_a<file> ());
+        if (f == nullptr)
+          continue;
+
+        const path& fp (f->derive_path ());
+
+        if (bs.empty () || bs.back ().size () == bn)
+          bs.push_back (vector<member> ());
+
+        bs.back ().push_back (member {i, fp, file_mtime (fp)});
+      }
+
+      dir_path d (unity_dir (t));
+
+      for (size_t k (0); k != bs.size (); ++k)
+      {
+        vector<member>& b (bs[k]);
+
+        string n ("batch-" + std::to_string (k + 1));
+
+        const file& s (search (t, x_src, d, dir_path (), n).as<file> ());
+        const path& sp (s.derive_path ());
+
+        // Read the previous version of the batch, if any.
+        //
+        string os;
+        timestamp omt (file_mtime (sp));
+
+        if (omt != timestamp_nonexistent)
+        {
+          try
+          {
+            ifdstream ifs (sp);
+            os = ifs.read_text ();
+          }
+          catch (const io_error&)
+          {
+            // Whatever the reason we failed for, let's regenerate from
+            // scratch.
+            //
+            omt = timestamp_nonexistent;
+          }
+        }
+
+        size_t mn (0); // Number of members modified since the last time.
+        if (omt != timestamp_nonexistent)
+        {
+          for (const member& m: b)
+            if (m.mt > omt)
+              ++mn;
+        }
+
+        bool rebatch (mn * 2 > b.size ());
+
+        string ns ("// Generated unity source, do not edit.\n");
+        bool empty (true);
+
+        for (const member& m: b)
+        {
+          string l ("#include \"" + m.src.string () + "\"\n");
+
+          if (m.mt == timestamp_nonexistent)
+            continue;
+
+          if (!rebatch &&
+              omt != timestamp_nonexistent &&
+              (m.mt > omt || os.find ("// " + l) != string::npos))
+          {
+            ns += "// ";
+            ns += l;
+            continue;
+          }
+
+          ns += l;
+          r.members[m.index] = r.batches.size () + 1;
+          empty = false;
+        }
+
+        if (a == perform_update_id && ns != os)
+        {
+          mkdir_p (d, 3);
+
+          if (verb >= 3)
+            text << "cat >" << sp;
+
+          try
+          {
+            ofdstream ofs (sp);
+            ofs << ns;
+            ofs.close ();
+          }
+          catch (const io_error& e)
+          {
+            fail << "unable to write to " << sp << ": " << e;
+          }
+        }
+
+        if (!empty)
+          r.batches.push_back (
+            unity_batch {s, search (t, tt.obj, d, dir_path (), n)});
+      }
+
+      r.seen.resize (r.batches.size (), false);
+      return r;
+    }
+  }
+}
@@ -4,9 +4,12 @@
 
 #include <build2/cc/utility.hxx>
 
+#include <cstring> // strlen(), strpbrk()
+
 #include <build2/file.hxx>
 #include <build2/variable.hxx>
 #include <build2/algorithm.hxx> // search()
+#include <build2/diagnostics.hxx>
 
 #include <build2/bin/rule.hxx>
 #include <build2/bin/target.hxx>
@@ -110,5 +113,164 @@ namespace build2
         return *(ls ? static_cast<const target*> (l.s) : l.a);
       }
     }
+
+    bool
+    rspfile (cstrings& args,
+             size_t start,
+             const path& f,
+             bool msvc,
+             auto_rmfile& rm,
+             string& arg,
+             cstrings* orig)
+    {
+      assert (!args.empty () && args.back () == nullptr);
+
+#ifdef _WIN32
+      // Calculate the would-be command line length similar to how process'
+      // implementation does it.
+      //
+      auto quote = [s = string ()] (const char* a) mutable -> const char*
+      {
+        return process::quote_argument (a, s);
+      };
+
+      size_t n (0);
+      for (const char* a: args)
+      {
+        if (a != nullptr)
+        {
+          if (n != 0)
+            n++; // For the space separator.
+
+          n += strlen (quote (a));
+        }
+      }
+
+      if (n <= 32766) // 32768 - "Unicode terminating null character".
+        return false;
+#else
+      // Here the limit (ARG_MAX) is normally in megabytes and includes the
+      // environment. However, long before we get anywhere near it, copying
+      // the arguments into the new process (and, at higher verbosity
+      // levels, printing them) becomes a noticeable cost. So we switch to
+      // the response file at a fairly conservative size.
+      //
+      size_t n (0);
+      for (const char* a: args)
+      {
+        if (a != nullptr)
+          n += strlen (a) + 1;
+      }
+
+      if (n <= 131072)
+        return false;
+#endif
+
+      try
+      {
+        ofdstream ofs ((rm = auto_rmfile (f)).path);
+
+        // Both Microsoft and GNU support a space-separated list of
+        // potentially-quoted arguments. GNU also supports backslash-escaping
+        // (whether Microsoft supports it is unclear; but it definitely
+        // doesn't need it for backslashes themselves, for example, in
+        // paths).
+        //
+        string b;
+
+        for (size_t i (start), e (args.size () - 1); i != e; ++i)
+        {
+          const char* a (args[i]);
+
+          if (i != start)
+            ofs << ' ';
+
+#ifdef _WIN32
+          if (!msvc) // We will most likely have backslashes so just do it.
+          {
+            for (b.clear (); *a != '\0'; ++a)
+            {
+              if (*a != '\\')
+                b += *a;
+              else
+                b += "\\\\";
+            }
+
+            a = b.c_str ();
+          }
+
+          ofs << quote (a);
+#else
+          b.clear ();
+
+          if (msvc)
+          {
+            // Quote if contains spaces or is empty.
+            //
+            bool q (*a == '\0' || strpbrk (a, " \t") != nullptr);
+
+            if (q)
+              b += '"';
+
+            for (; *a != '\0'; ++a)
+            {
+              if (*a == '"')
+                b += '\\';
+
+              b += *a;
+            }
+
+            if (q)
+              b += '"';
+          }
+          else
+          {
+            if (*a == '\0')
+              b = "''";
+
+            for (; *a != '\0'; ++a)
+            {
+              switch (*a)
+              {
+              case ' ':
+              case '\t':
+              case '\n':
+              case '\'':
+              case '"':
+              case '\\': b += '\\'; // Fall through.
+              default:   b += *a;
+              }
+            }
+          }
+
+          ofs << b;
+#endif
+        }
+
+        ofs << '\n';
+        ofs.close ();
+      }
+      catch (const io_error& e)
+      {
+        fail << "unable to write " << f << ": " << e;
+      }
+
+      // Replace the arguments with @file.
+      //
+      arg = '@' + f.string ();
+
+      if (orig != nullptr)
+      {
+        *orig = move (args);
+        args.assign (orig->begin (), orig->begin () + start);
+      }
+      else
+        args.resize (start);
+
+      args.push_back (arg.c_str ());
+      args.push_back (nullptr);
+
+      return true;
+    }
   }
 }
@@ -9,8 +9,11 @@
 #include <build2/utility.hxx>
 
 #include <build2/target.hxx>
+#include <build2/filesystem.hxx> // auto_rmfile
 #include <build2/bin/target.hxx>
 
+#include <build2/cc/target.hxx> // pch*
+
 #include <build2/cc/types.hxx>
 
 namespace build2
@@ -27,6 +30,11 @@ namespace build2
     otype
     compile_type (const target&, bool module);
 
+    // Precompiled header output type.
+    //
+    otype
+    pch_type (const target&);
+
     compile_target_types
     compile_types (otype);
 
@@ -58,6 +66,28 @@ namespace build2
     //
     const target&
     link_member (const bin::libx&, action, linfo);
+
+    // If the (NULL-terminated) command line is too long to be passed
+    // directly, then write the arguments starting from the specified
+    // position into the response (options) file and replace them with
+    // @<file>. Return true if that was the case, in which case the file is
+    // removed by the passed auto_rmfile and the replacement argument is
+    // stored in the passed string. If msvc is true, then use the Microsoft
+    // content format and GNU otherwise. If orig is not NULL, then also move
+    // the original arguments there (only if the response file is used).
+    //
+    // The caller is expected to make sure the program supports response
+    // files, which GCC, Clang, and MSVC compiler drivers (that also pass
+    // them on to the linker) as well as GNU, LLVM, and MSVC archivers do.
+    //
+    bool
+    rspfile (cstrings& args,
+             size_t start,
+             const path& file,
+             bool msvc,
+             auto_rmfile&,
+             string&,
+             cstrings* orig = nullptr);
   }
 }
 
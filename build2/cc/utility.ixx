@@ -17,6 +17,15 @@ namespace build2
         otype::s;
     }
 
+    inline otype
+    pch_type (const target& t)
+    {
+      return
+        t.is_a<pche> () ? otype::e :
+        t.is_a<pcha> () ? otype::a :
+        otype::s;
+    }
+
     inline ltype
     link_type (const target& t)
     {
@@ -39,15 +48,22 @@ namespace build2
 
       const target_type* o (nullptr);
       const target_type* m (nullptr);
+      const target_type* p (nullptr);
 
       switch (t)
       {
-      case otype::e: o = &obje::static_type; m = &bmie::static_type; break;
-      case otype::a: o = &obja::static_type; m = &bmia::static_type; break;
-      case otype::s: o = &objs::static_type; m = &bmis::static_type; break;
+      case otype::e:
+        o = &obje::static_type; m = &bmie::static_type; p = &pche::static_type;
+        break;
+      case otype::a:
+        o = &obja::static_type; m = &bmia::static_type; p = &pcha::static_type;
+        break;
+      case otype::s:
+        o = &objs::static_type; m = &bmis::static_type; p = &pchs::static_type;
+        break;
       }
 
-      return compile_target_types {*o, *m};
+      return compile_target_types {*o, *m, *p};
     }
   }
 }
@@ -638,6 +638,16 @@ namespace build2
 
         r = rmfile (out_root / config_file) || r;
 
+        // Remove the toolchain probe cache (see probe-cache.hxx for
+        // details).
+        //
+        r = rmdir_r (out_root / probe_dir, true, 2) || r;
+
+        // Remove the buildfile token stream cache (see token-cache.hxx for
+        // details).
+        //
+        r = rmdir_r (out_root / token_dir, true, 2) || r;
+
         if (out_root != src_root)
         {
           r = rmfile (out_root / src_root_file, 2) || r;
@@ -363,6 +363,14 @@ namespace build2
   atomic_count target_count;
   atomic_count skip_count;
 
+  atomic_count stat_headers_pregenerated;
+  atomic_count stat_object_bytes;
+  atomic_count stat_link_msec;
+  atomic_count stat_pattern_tests;
+  atomic_count stat_pattern_matches;
+  atomic_count stat_buildfiles_replayed;
+  atomic_count stat_buildfiles_lexed;
+
   bool keep_going = false;
 
   variable_overrides
@@ -362,6 +362,37 @@ namespace build2
   extern atomic_count target_count;
   extern atomic_count skip_count;
 
+  // Build statistics that are accumulated over the entire build system
+  // invocation and reported with --stat.
+  //
+  // The number of generated headers that were changed by updating them ahead
+  // of the header dependency extraction (see cc.pregenerate).
+  //
+  extern atomic_count stat_headers_pregenerated;
+
+  // The total size of the object files (including split DWARF .dwo files)
+  // produced by the compile rules, in bytes.
+  //
+  extern atomic_count stat_object_bytes;
+
+  // The total time spent running the linker (and .dwp packaging), in
+  // milliseconds.
+  //
+  extern atomic_count stat_link_msec;
+
+  // The number of target type/pattern-specific variable patterns tested
+  // against target names and how many of them matched. Note that the
+  // results are cached per target name (see variable_pattern_map::match()).
+  //
+  extern atomic_count stat_pattern_tests;
+  extern atomic_count stat_pattern_matches;
+
+  // The number of buildfiles that were replayed from the token stream cache
+  // and that had to be (fully or partially) lexed (see token-cache.hxx).
+  //
+  extern atomic_count stat_buildfiles_replayed;
+  extern atomic_count stat_buildfiles_lexed;
+
   inline void
   set_current_mif (const meta_operation_info& mif)
   {
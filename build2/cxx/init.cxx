@@ -8,6 +8,8 @@
 #include <build2/context.hxx>
 #include <build2/diagnostics.hxx>
 
+#include <build2/config/utility.hxx>
+
 #include <build2/cc/guess.hxx>
 #include <build2/cc/module.hxx>
 
@@ -377,20 +379,22 @@ namespace build2
         v.insert<dir_paths>    ("cxx.sys_lib_dirs"),
         v.insert<dir_paths>    ("cxx.sys_inc_dirs"),
 
-        v.insert<strings> ("cxx.poptions"),
-        v.insert<strings> ("cxx.coptions"),
-        v.insert<strings> ("cxx.loptions"),
-        v.insert<strings> ("cxx.libs"),
+        // Looked up on every target (see variable_pool::insert_slot()).
+        //
+        v.insert_slot<strings> ("cxx.poptions"),
+        v.insert_slot<strings> ("cxx.coptions"),
+        v.insert_slot<strings> ("cxx.loptions"),
+        v.insert_slot<strings> ("cxx.libs"),
 
         v["cc.poptions"],
         v["cc.coptions"],
         v["cc.loptions"],
         v["cc.libs"],
 
-        v.insert<strings>      ("cxx.export.poptions"),
-        v.insert<strings>      ("cxx.export.coptions"),
-        v.insert<strings>      ("cxx.export.loptions"),
-        v.insert<vector<name>> ("cxx.export.libs"),
+        v.insert_slot<strings>      ("cxx.export.poptions"),
+        v.insert_slot<strings>      ("cxx.export.coptions"),
+        v.insert_slot<strings>      ("cxx.export.loptions"),
+        v.insert_slot<vector<name>> ("cxx.export.libs"),
 
         v["cc.export.poptions"],
         v["cc.export.coptions"],
@@ -406,6 +410,12 @@ namespace build2
         v["cc.system"],
         v["cc.module_name"],
         v["cc.reprocess"],
+        v["cc.pregenerate"],
+        v["cc.batch"],
+        v["cc.bmi_cache"],
+        v["cc.split_dwarf"],
+        v["cc.compress_debug"],
+        v["cc.dwp"],
 
         // Ability to signal that source is already (partially) preprocessed.
         // Valid values are 'none' (not preprocessed), 'includes' (no #include
@@ -418,7 +428,18 @@ namespace build2
         //
         v.insert<string>   ("cxx.preprocessed"),
 
+        // Unity (also known as jumbo) build: compile sources of an
+        // executable or library in batches of cxx.unity.batch (16 by
+        // default) translation units, each batch being a generated source
+        // file that includes its members. An individual source can be
+        // excluded from batching with the prerequisite-specific cxx.unity
+        // set to false. See unity_partition() in cc/unity.cxx for details.
+        //
+        v.insert<bool>     ("cxx.unity", true),
+        v.insert<uint64_t> ("cxx.unity.batch", true),
+
         nullptr, // cxx.features.symexport (set in init() below).
+        nullptr, // cxx.importable_headers (set in init() below).
 
         v.insert<string>   ("cxx.std", variable_visibility::project),
 
@@ -544,6 +565,21 @@ namespace build2
                                     variable_visibility::project));
         symexport = cast_false<bool> (rs[var]);
         cm.x_symexport = &var;
+
+        // Headers that can be imported as header units and for which
+        // #include is translated to import. Each entry is either an absolute
+        // path or a <>-name that is resolved using the system header search
+        // directories. See compile_rule::importable_header_units() for
+        // details.
+        //
+        auto& cvar (vp.insert<strings> ("config.cxx.importable_headers",
+                                        true));
+        auto& hvar (vp.insert<strings> ("cxx.importable_headers"));
+
+        if (lookup l = config::omitted (rs, cvar).first)
+          rs.assign (hvar) = *l;
+
+        cm.x_importable_headers = &hvar;
       }
 
       cc::data d {
@@ -563,6 +599,8 @@ namespace build2
         cast<target_triplet> (rs[cm.x_target]),
 
         cm.tstd,
+        cm.tld,
+        cm.ld_checksum,
 
         modules,
         symexport,
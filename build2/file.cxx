@@ -27,6 +27,8 @@ namespace build2
   const dir_path build_dir     ("build");
   const dir_path root_dir      (dir_path (build_dir) /= "root");
   const dir_path bootstrap_dir (dir_path (build_dir) /= "bootstrap");
+  const dir_path probe_dir     (dir_path (build_dir) /= "probe");
+  const dir_path token_dir     (dir_path (build_dir) /= "tokens");
 
   const path root_file      (build_dir     / "root.build");
   const path bootstrap_file (build_dir     / "bootstrap.build");
@@ -27,6 +27,8 @@ namespace build2
   extern const dir_path build_dir;     // build/
   extern const dir_path root_dir;      // build/root/
   extern const dir_path bootstrap_dir; // build/bootstrap/
+  extern const dir_path probe_dir;     // build/probe/
+  extern const dir_path token_dir;     // build/tokens/
 
   extern const path root_file;         // build/root.build
   extern const path bootstrap_file;    // build/bootstrap.build
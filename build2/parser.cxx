@@ -247,8 +247,9 @@ namespace build2
   {
     path_ = &p;
 
-    lexer l (is, *path_);
-    lexer_ = &l;
+    token_cache tc (is, *path_, root.out_path_);
+    tcache_ = &tc;
+    lexer_ = nullptr;
     root_ = &root;
     scope_ = &base;
     pbase_ = scope_->src_path_;
@@ -268,6 +269,9 @@ namespace build2
       fail (t) << "unexpected " << t;
 
     process_default_target (t);
+
+    tc.save ();
+    tcache_ = nullptr;
   }
 
   token parser::
@@ -275,6 +279,7 @@ namespace build2
   {
     path_ = &l.name ();
     lexer_ = &l;
+    tcache_ = nullptr;
     scope_ = &s;
     pbase_ = scope_->src_path_; // Normally NULL.
     target_ = nullptr;
@@ -294,6 +299,7 @@ namespace build2
   {
     path_ = &l.name ();
     lexer_ = &l;
+    tcache_ = nullptr;
     scope_ = &s;
     pbase_ = b;
     target_ = nullptr;
@@ -1118,9 +1124,11 @@ namespace build2
     const path* op (path_);
     path_ = &p;
 
-    lexer l (is, *path_);
+    token_cache tc (is, *path_, root_->out_path_);
     lexer* ol (lexer_);
-    lexer_ = &l;
+    token_cache* otc (tcache_);
+    lexer_ = nullptr;
+    tcache_ = &tc;
 
     target* odt;
     if (deft)
@@ -1143,7 +1151,10 @@ namespace build2
       default_target_ = odt;
     }
 
+    tc.save ();
+
     lexer_ = ol;
+    tcache_ = otc;
     path_ = op;
 
     l5 ([&]{trace (loc) << "leaving " << p;});
@@ -1944,9 +1955,28 @@ namespace build2
     // sequence that comprises the body. Then we re-lex/parse it on each
     // iteration.
     //
+    // Note that if we are using the token stream cache, then it saves (and
+    // replays) the character sequence for us.
+    //
     string body;
-    uint64_t line (lexer_->line); // Line of the first character to be saved.
-    lexer::save_guard sg (*lexer_, body);
+    uint64_t line; // Line of the first character to be saved.
+    unique_ptr<lexer::save_guard> sg;
+
+    if (tcache_ != nullptr)
+      line = tcache_->raw_begin ();
+    else
+    {
+      line = lexer_->line;
+      sg.reset (new lexer::save_guard (*lexer_, body));
+    }
+
+    auto stop_save = [this, &body, &sg] ()
+    {
+      if (sg != nullptr)
+        sg->stop ();
+      else
+        body = tcache_->raw_end ();
+    };
 
     // This can be a block or a single line, similar to if-else.
     //
@@ -1958,7 +1988,7 @@ namespace build2
       next (t, tt);
 
       skip_block (t, tt);
-      sg.stop ();
+      stop_save ();
 
       if (tt != type::rcbrace)
         fail (t) << "expected } instead of " << t << " at the end of for-block";
@@ -1973,7 +2003,7 @@ namespace build2
     else
     {
       skip_line (t, tt);
-      sg.stop ();
+      stop_save ();
 
       if (tt == type::newline)
         next (t, tt);
@@ -2005,7 +2035,9 @@ namespace build2
 
       lexer l (is, *path_, line);
       lexer* ol (lexer_);
+      token_cache* otc (tcache_);
       lexer_ = &l;
+      tcache_ = nullptr;
 
       token t;
       type tt;
@@ -2020,6 +2052,7 @@ namespace build2
       assert (tt == (block ? type::rcbrace : type::eos));
 
       lexer_ = ol;
+      tcache_ = otc;
 
       if (++i == e)
         break;
@@ -4732,7 +4765,9 @@ namespace build2
       // We cannot peek at the whole token here since it might have to be
       // lexed in a different mode. So peek at its first character.
       //
-      pair<char, bool> p (lexer_->peek_char ());
+      pair<char, bool> p (tcache_ != nullptr
+                          ? tcache_->peek_char ()
+                          : lexer_->peek_char ());
       char c (p.first);
 
       // @@ Just checking for leading '+' is not sufficient, for example:
@@ -4785,6 +4820,7 @@ namespace build2
     //
     lexer l (is, *path_, 1 /* line */, "\'\"\\$(");
     lexer_ = &l;
+    tcache_ = nullptr;
     scope_ = root_ = scope::global_;
     pbase_ = &work; // Use current working directory.
     target_ = nullptr;
@@ -15,6 +15,7 @@
 #include <build2/token.hxx>
 #include <build2/variable.hxx>
 #include <build2/diagnostics.hxx>
+#include <build2/token-cache.hxx>
 
 namespace build2
 {
@@ -456,7 +457,12 @@ namespace build2
     mode (lexer_mode m, char ps = '\0')
     {
       if (replay_ != replay::play)
-        lexer_->mode (m, ps);
+      {
+        if (tcache_ != nullptr)
+          tcache_->mode (m, ps);
+        else
+          lexer_->mode (m, ps);
+      }
       else
         // As a sanity check, make sure the mode matches the next token. Note
         // that we don't check the pair separator since it can be overriden by
@@ -470,7 +476,7 @@ namespace build2
     mode () const
     {
       if (replay_ != replay::play)
-        return lexer_->mode ();
+        return tcache_ != nullptr ? tcache_->mode () : lexer_->mode ();
       else
       {
         assert (replay_i_ != replay_data_.size ());
@@ -482,7 +488,12 @@ namespace build2
     expire_mode ()
     {
       if (replay_ != replay::play)
-        lexer_->expire_mode ();
+      {
+        if (tcache_ != nullptr)
+          tcache_->expire_mode ();
+        else
+          lexer_->expire_mode ();
+      }
     }
 
     // Token saving and replaying. Note that it can only be used in certain
@@ -581,6 +592,12 @@ namespace build2
     replay_token
     lexer_next ()
     {
+      if (tcache_ != nullptr)
+      {
+        pair<token, lexer_mode> r (tcache_->next ());
+        return replay_token {move (r.first), path_, r.second};
+      }
+
       lexer_mode m (lexer_->mode ()); // Get it first since it may expire.
       return replay_token {lexer_->next (), path_, m};
     }
@@ -611,6 +628,7 @@ namespace build2
 
     const path* path_; // Current path.
     lexer* lexer_;
+    token_cache* tcache_ = nullptr; // Used instead of lexer_ if not NULL.
     prerequisite* prerequisite_; // Current prerequisite, if any.
     target* target_;             // Current target, if any.
     scope* scope_;               // Current base scope (out_base).
@@ -0,0 +1,196 @@
+// file      : build2/probe-cache.cxx -*- C++ -*-
+// copyright : Copyright (c) 2014-2019 Code Synthesis Ltd
+// license   : MIT; see accompanying LICENSE file
+
+#include <build2/probe-cache.hxx>
+
+#include <build2/file.hxx>        // probe_dir
+#include <build2/filesystem.hxx>
+#include <build2/diagnostics.hxx>
+
+using namespace std;
+using namespace butl;
+
+namespace build2
+{
+  string
+  probe_key (const char* kind,
+             const process_path& pp,
+             initializer_list<const char*> env,
+             const string& extra)
+  {
+    if (pp.empty ())
+      return string ();
+
+    path tool (pp.effect_string ());
+
+    sha256 cs;
+    cs.append (kind);
+    cs.append (BUILD2_VERSION_ID);
+    cs.append (tool.string ());
+
+    try
+    {
+      pair<bool, entry_stat> pe (
+        path_entry (tool, true /* follow_symlinks */));
+
+      if (!pe.first)
+        return string ();
+
+      timestamp mt (file_mtime (tool));
+
+      if (mt == timestamp_nonexistent)
+        return string ();
+
+      cs.append (pe.second.size);
+      cs.append (static_cast<uint64_t> (mt.time_since_epoch ().count ()));
+    }
+    catch (const system_error&)
+    {
+      return string ();
+    }
+
+    for (const char* n: env)
+    {
+      cs.append (n);
+
+      if (optional<string> v = getenv (n))
+      {
+        cs.append ('=');
+        cs.append (*v);
+      }
+      else
+        cs.append ('\0');
+    }
+
+    cs.append (extra);
+    return cs.string ();
+  }
+
+  // The entry file is named <kind>-<key-prefix> and its contents are the
+  // full key line followed by the data checksum line and the data which is
+  // the line count followed by the lines. The checksum allows us to detect
+  // a partially-written (for example, due to a crash or a concurrent
+  // invocation) entry.
+  //
+  static inline path
+  probe_file (const dir_path& out_root, const char* kind, const string& key)
+  {
+    return out_root / probe_dir / path (string (kind) + '-' +
+                                        string (key, 0, 16));
+  }
+
+  optional<strings>
+  probe_load (const dir_path& out_root, const char* kind, const string& key)
+  {
+    tracer trace ("probe_load");
+
+    if (key.empty ())
+      return nullopt;
+
+    path f (probe_file (out_root, kind, key));
+
+    try
+    {
+      if (!file_exists (f))
+        return nullopt;
+
+      string d;
+      {
+        ifdstream ifs (f, ifdstream::badbit);
+
+        string l;
+        if (!getline (ifs, l) || l != key || !getline (ifs, l))
+          return nullopt;
+
+        d = ifs.read_text ();
+
+        if (sha256 (d).string () != l)
+          return nullopt;
+      }
+
+      size_t b (d.find ('\n'));
+      if (b == string::npos)
+        return nullopt;
+
+      size_t n (static_cast<size_t> (stoull (string (d, 0, b))));
+
+      strings r;
+      r.reserve (n);
+
+      for (size_t e; n != 0 && (e = d.find ('\n', ++b)) != string::npos; --n)
+      {
+        r.push_back (string (d, b, e - b));
+        b = e;
+      }
+
+      if (n != 0 || b + 1 != d.size ())
+        return nullopt;
+
+      l5 ([&]{trace << "loaded " << f;});
+      return r;
+    }
+    catch (const invalid_argument&) {}
+    catch (const out_of_range&) {}
+    catch (const io_error&) {}
+    catch (const system_error&) {}
+
+    l4 ([&]{trace << "unable to load " << f;});
+    return nullopt;
+  }
+
+  void
+  probe_save (const dir_path& out_root,
+              const char* kind,
+              const string& key,
+              const strings& data)
+  {
+    tracer trace ("probe_save");
+
+    if (key.empty ())
+      return;
+
+    path f (probe_file (out_root, kind, key));
+
+    // Assemble everything in memory to minimize the chance of a concurrent
+    // invocation seeing a partially-written file (and if it does, then it
+    // will be a cache miss thanks to the data checksum).
+    //
+    string d (to_string (data.size ()));
+    d += '\n';
+
+    for (const string& l: data)
+    {
+      d += l;
+      d += '\n';
+    }
+
+    string s (key);
+    s += '\n';
+    s += sha256 (d).string ();
+    s += '\n';
+    s += d;
+
+    if (verb >= 3)
+      text << "cat >" << f;
+
+    try
+    {
+      try_mkdir_p (f.directory ());
+
+      ofdstream ofs (f);
+      ofs << s;
+      ofs.close ();
+
+      l5 ([&]{trace << "saved " << f;});
+    }
+    catch (const io_error& e)
+    {
+      l4 ([&]{trace << "unable to write to " << f << ": " << e;});
+    }
+    catch (const system_error& e)
+    {
+      l4 ([&]{trace << "unable to create " << f.directory () << ": " << e;});
+    }
+  }
+}
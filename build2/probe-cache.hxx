@@ -0,0 +1,54 @@
+// file      : build2/probe-cache.hxx -*- C++ -*-
+// copyright : Copyright (c) 2014-2019 Code Synthesis Ltd
+// license   : MIT; see accompanying LICENSE file
+
+#ifndef BUILD2_PROBE_CACHE_HXX
+#define BUILD2_PROBE_CACHE_HXX
+
+#include <build2/types.hxx>
+#include <build2/utility.hxx>
+
+namespace build2
+{
+  // Persistent toolchain probe cache.
+  //
+  // Guessing the compiler, archiver, linker, etc., as well as extracting
+  // things like the compiler's system header and library search paths
+  // involves running these tools, often several times. To avoid doing this
+  // on every build system invocation we cache the results in the project's
+  // out_root/build/probe/ directory (removed by disfigure).
+  //
+  // An entry is identified by its kind (for example, cc.guess) and a key
+  // that is calculated from the build system version, the tool's effective
+  // path, its size and modification time, the values of the environment
+  // variables that affect the tool's behavior as well as any extra data
+  // (for example, options) that affect the result. The build system version
+  // is included since the probing logic itself may change between versions
+  // without the entry format changing. The entry data is a list of lines
+  // that is written and parsed by the caller. Any error or mismatch is
+  // treated as a cache miss and the entry is silently overwritten on save.
+  //
+  // Note that the kind should include the entry format version so that it
+  // is invalidated if the format changes.
+  //
+
+  // Return the key or empty string if the tool cannot be examined (in which
+  // case the cache should not be used).
+  //
+  string
+  probe_key (const char* kind,
+             const process_path& tool,
+             initializer_list<const char*> env,
+             const string& extra);
+
+  optional<strings>
+  probe_load (const dir_path& out_root, const char* kind, const string& key);
+
+  void
+  probe_save (const dir_path& out_root,
+              const char* kind,
+              const string& key,
+              const strings& data);
+}
+
+#endif // BUILD2_PROBE_CACHE_HXX
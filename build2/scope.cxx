@@ -47,11 +47,13 @@ namespace build2
       //
       lookup stem (s->find_original (var, tt, tn, gt, gn, 2).first);
 
-      // Check the cache.
+      // Check the cache. Note that the result only depends on the value and
+      // the stem so all the targets that end up with the same stem share
+      // the cache entry (see variable_type_map::cache for details).
       //
       pair<value&, ulock> entry (
         s->target_vars.cache.insert (
-          make_tuple (&v, tt, *tn),
+          make_pair (&v, stem.value),
           stem,
           static_cast<const variable_map::value_data&> (v).version,
           var));
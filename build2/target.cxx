@@ -171,6 +171,85 @@ namespace build2
     return r;
   }
 
+  pair<lookup, size_t> target::
+  find_memoized (const variable& var) const
+  {
+    // During load the scope state can change at any moment.
+    //
+    if (phase == run_phase::load)
+      return find (var);
+
+    pair<lookup, size_t> r (find_original (var, true /* target_only */));
+
+    if (!r.first)
+    {
+      // Same logic as in find_original().
+      //
+      const target* g (group == nullptr
+                       ? nullptr
+                       : group->adhoc_group () ? group->group : group);
+
+      size_t gen (variable_generation);
+
+      shared_mutex& m (
+        variable_cache_mutex_shard[
+          hash<const target*> () (this) % variable_cache_mutex_shard_size]);
+
+      pair<lookup, size_t> p (lookup (), 0);
+      bool hit (false);
+      {
+        slock l (m);
+
+        for (const memo_entry& e: memo_)
+        {
+          if (e.var == &var)
+          {
+            if (e.group == g && e.generation == gen)
+            {
+              p = e.result;
+              hit = true;
+            }
+            break;
+          }
+        }
+      }
+
+      if (!hit)
+      {
+        p = base_scope ().find_original (
+          var,
+          &type (),
+          &name,
+          g != nullptr ? &g->type () : nullptr,
+          g != nullptr ? &g->name : nullptr);
+
+        ulock l (m);
+
+        auto i (find_if (memo_.begin (), memo_.end (),
+                         [&var] (const memo_entry& e)
+                         {
+                           return e.var == &var;
+                         }));
+
+        if (i != memo_.end ())
+        {
+          i->group = g;
+          i->generation = gen;
+          i->result = p;
+        }
+        else
+          memo_.push_back (memo_entry {&var, g, gen, p});
+      }
+
+      r.first = move (p.first);
+      r.second = r.first ? 2 + p.second : p.second;
+    }
+
+    return var.override == nullptr
+      ? r
+      : base_scope ().find_override (var, move (r), true);
+  }
+
   value& target::
   append (const variable& var)
   {
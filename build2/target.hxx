@@ -410,6 +410,48 @@ namespace build2
     pair<lookup, size_t>
     find_original (const variable&, bool target_only = false) const;
 
+    // As find() but memoize the part of the lookup that is performed in
+    // scopes (target type/pattern-specific and scope variables) so that
+    // subsequent lookups of the same variable on this target only need to
+    // check the target and group variables (which rules can still set
+    // during match) and then scan a short array.
+    //
+    // The memo is only used after the load phase and is invalidated if the
+    // global variable state changes (see variable_generation) or the target
+    // is assigned a different group. This is an opt-in mechanism (it costs
+    // an entry per variable per target) that is meant for rules that
+    // perform many lookups on the same target (e.g., cc::compile_rule).
+    //
+    pair<lookup, size_t>
+    find_memoized (const variable&) const;
+
+    lookup
+    memoized (const variable& var) const
+    {
+      return find_memoized (var).first;
+    }
+
+    lookup
+    memoized (const variable* var) const // For cached variables.
+    {
+      assert (var != nullptr);
+      return memoized (*var);
+    }
+
+  private:
+    struct memo_entry
+    {
+      const variable*      var;
+      const target*        group;      // Group used in the lookup.
+      size_t               generation; // variable_generation of the lookup.
+      pair<lookup, size_t> result;     // Scope part of the lookup.
+    };
+
+    // Protected by variable_cache_mutex_shard.
+    //
+    mutable vector<memo_entry> memo_;
+
+  public:
     // Return a value suitable for assignment. See scope for details.
     //
     value&
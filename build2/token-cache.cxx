@@ -0,0 +1,619 @@
+// file      : build2/token-cache.cxx -*- C++ -*-
+// copyright : Copyright (c) 2014-2019 Code Synthesis Ltd
+// license   : MIT; see accompanying LICENSE file
+
+#include <build2/token-cache.hxx>
+
+#include <build2/file.hxx>        // token_dir, config_file
+#include <build2/context.hxx>     // stat_buildfiles_*
+#include <build2/filesystem.hxx>
+#include <build2/diagnostics.hxx>
+
+using namespace std;
+using namespace butl;
+
+namespace build2
+{
+  // Entry format version (part of the key).
+  //
+  static const char token_format[] = "tokens-2";
+
+  // The entry file is named after the buildfile path checksum and its
+  // contents are the key line, the data checksum line, and the data. The
+  // data is the event count followed by the events with all the integers
+  // encoded as LEB128 and strings as their size followed by characters.
+  //
+  static inline void
+  write_uint (string& s, uint64_t v)
+  {
+    for (; v >= 0x80; v >>= 7)
+      s += static_cast<char> ((v & 0x7f) | 0x80);
+
+    s += static_cast<char> (v);
+  }
+
+  static inline void
+  write_string (string& s, const string& v)
+  {
+    write_uint (s, v.size ());
+    s += v;
+  }
+
+  namespace
+  {
+    struct reader
+    {
+      const char* p;
+      const char* e;
+
+      bool
+      read_uint (uint64_t& r)
+      {
+        r = 0;
+
+        for (unsigned int s (0); p != e && s < 64; s += 7)
+        {
+          unsigned char c (static_cast<unsigned char> (*p++));
+          r |= static_cast<uint64_t> (c & 0x7f) << s;
+
+          if ((c & 0x80) == 0)
+            return true;
+        }
+
+        return false;
+      }
+
+      template <typename T>
+      bool
+      read_uint (T& r, uint64_t max)
+      {
+        uint64_t v;
+        if (!read_uint (v) || v >= max)
+          return false;
+
+        r = static_cast<T> (v);
+        return true;
+      }
+
+      bool
+      read_string (string& r)
+      {
+        uint64_t n;
+        if (!read_uint (n) || n > static_cast<uint64_t> (e - p))
+          return false;
+
+        r.assign (p, static_cast<size_t> (n));
+        p += n;
+        return true;
+      }
+    };
+  }
+
+  token_cache::
+  token_cache (istream& is, const path& n, const dir_path* out_root)
+      : is_ (is), name_ (n)
+  {
+    // Only use the cache in configured projects so that we don't litter
+    // (normally in-source) trees that were never explicitly configured.
+    //
+    if (out_root != nullptr && n.absolute ())
+    {
+      try
+      {
+        path cf (*out_root / config_file);
+
+        if (exists (cf, true /* follow_symlinks */, true /* ignore_error */))
+        {
+          // Hash the buildfile contents rather than relying on its size and
+          // modification time which may not change if it is modified within
+          // the filesystem timestamp granularity.
+          //
+          sha256 cs;
+          cs.append (token_format);
+          cs.append (BUILD2_VERSION_ID);
+          cs.append (n.string ());
+
+          ifdstream ifs (n, fdopen_mode::binary, ifdstream::badbit);
+
+          char buf[8192];
+          do
+          {
+            ifs.read (buf, sizeof (buf));
+            cs.append (buf, static_cast<size_t> (ifs.gcount ()));
+          }
+          while (!ifs.eof ());
+
+          key_ = cs.string ();
+
+          sha256 ns;
+          ns.append (n.string ());
+          file_ = *out_root / token_dir / path (string (ns.string (), 0, 16));
+        }
+      }
+      catch (const io_error&)
+      {
+        key_.clear (); // Don't use the cache.
+      }
+      catch (const system_error&)
+      {
+        key_.clear ();
+      }
+    }
+
+    if (key_.empty () || !load ())
+      live ();
+  }
+
+  lexer& token_cache::
+  live ()
+  {
+    if (lexer_ == nullptr)
+    {
+      tracer trace ("token_cache::live");
+
+      lexer_.reset (new lexer (is_, name_));
+
+      // Bring the lexer to the state after the calls replayed so far. Note
+      // that we haven't read anything from the stream yet.
+      //
+      for (size_t i (0); i != pos_; ++i)
+      {
+        const event& e (events_[i]);
+
+        switch (e.kind)
+        {
+        case event::set_mode:    lexer_->mode (e.mode, e.chr); break;
+        case event::get_mode:                                   break;
+        case event::expire_mode: lexer_->expire_mode ();        break;
+        case event::next:        lexer_->next ();               break;
+        case event::peek_char:   lexer_->peek_char ();          break;
+        case event::raw_begin:   start_raw ();                  break;
+        case event::raw_end:     raw_guard_.reset ();           break;
+        }
+      }
+
+      if (!events_.empty ())
+        l5 ([&]{trace << "switching to lexer for " << name_ << " after "
+                      << pos_ << " of " << events_.size () << " events";});
+
+      events_.erase (events_.begin () + pos_, events_.end ());
+    }
+
+    return *lexer_;
+  }
+
+  inline void token_cache::
+  start_raw ()
+  {
+    raw_.clear ();
+    raw_guard_.reset (new lexer::save_guard (*lexer_, raw_));
+  }
+
+  template <typename F>
+  inline const token_cache::event* token_cache::
+  replay (event::kind_type k, F&& f)
+  {
+    if (lexer_ == nullptr)
+    {
+      if (pos_ != events_.size ())
+      {
+        const event& e (events_[pos_]);
+
+        if (e.kind == k && f (e))
+        {
+          ++pos_;
+          return &e;
+        }
+      }
+
+      live ();
+    }
+
+    return nullptr;
+  }
+
+  inline void token_cache::
+  record (event&& e)
+  {
+    if (!key_.empty ())
+    {
+      events_.push_back (move (e));
+      pos_ = events_.size ();
+    }
+  }
+
+  void token_cache::
+  mode (lexer_mode m, char ps)
+  {
+    if (replay (event::set_mode,
+                [m, ps] (const event& e) {return e.mode == m && e.chr == ps;}))
+      return;
+
+    lexer_->mode (m, ps);
+
+    event e;
+    e.kind = event::set_mode;
+    e.mode = m;
+    e.chr = ps;
+    record (move (e));
+  }
+
+  lexer_mode token_cache::
+  mode ()
+  {
+    if (const event* r = replay (event::get_mode,
+                                 [] (const event&) {return true;}))
+      return r->mode;
+
+    lexer_mode m (lexer_->mode ());
+
+    event e;
+    e.kind = event::get_mode;
+    e.mode = m;
+    record (move (e));
+
+    return m;
+  }
+
+  void token_cache::
+  expire_mode ()
+  {
+    if (replay (event::expire_mode, [] (const event&) {return true;}))
+      return;
+
+    lexer_->expire_mode ();
+
+    event e;
+    e.kind = event::expire_mode;
+    record (move (e));
+  }
+
+  pair<token, lexer_mode> token_cache::
+  next ()
+  {
+    if (const event* r = replay (event::next,
+                                 [] (const event&) {return true;}))
+      return make_pair (r->tok, r->mode);
+
+    lexer_mode m (lexer_->mode ()); // Get it first since it may expire.
+    token t (lexer_->next ());
+
+    if (!key_.empty ())
+    {
+      event e;
+      e.kind = event::next;
+      e.mode = m;
+      e.tok = t;
+      record (move (e));
+    }
+
+    return make_pair (move (t), m);
+  }
+
+  pair<char, bool> token_cache::
+  peek_char ()
+  {
+    if (const event* r = replay (event::peek_char,
+                                 [] (const event&) {return true;}))
+      return make_pair (r->chr, r->sep);
+
+    pair<char, bool> p (lexer_->peek_char ());
+
+    event e;
+    e.kind = event::peek_char;
+    e.chr = p.first;
+    e.sep = p.second;
+    record (move (e));
+
+    return p;
+  }
+
+  uint64_t token_cache::
+  raw_begin ()
+  {
+    if (const event* r = replay (event::raw_begin,
+                                 [] (const event&) {return true;}))
+      return r->tok.line;
+
+    uint64_t l (lexer_->line);
+    start_raw ();
+
+    event e;
+    e.kind = event::raw_begin;
+    e.tok.line = l;
+    record (move (e));
+
+    return l;
+  }
+
+  string token_cache::
+  raw_end ()
+  {
+    if (const event* r = replay (event::raw_end,
+                                 [] (const event&) {return true;}))
+      return r->tok.value;
+
+    // Note that we could have switched to the real lexer after replaying
+    // raw_begin() in which case live() has restarted the saving.
+    //
+    assert (raw_guard_ != nullptr);
+    raw_guard_.reset ();
+
+    if (!key_.empty ())
+    {
+      event e;
+      e.kind = event::raw_end;
+      e.tok.value = raw_;
+      record (move (e));
+    }
+
+    return move (raw_);
+  }
+
+  bool token_cache::
+  load ()
+  {
+    tracer trace ("token_cache::load");
+
+    try
+    {
+      if (!file_exists (file_))
+        return false;
+
+      string s;
+      {
+        ifdstream is (file_, fdopen_mode::binary, ifdstream::badbit);
+
+        char buf[8192];
+        do
+        {
+          is.read (buf, sizeof (buf));
+          s.append (buf, static_cast<size_t> (is.gcount ()));
+        }
+        while (!is.eof ());
+      }
+
+      if (decode (s))
+      {
+        l5 ([&]{trace << "loaded " << file_ << " for " << name_;});
+        return true;
+      }
+    }
+    catch (const io_error&) {}
+    catch (const system_error&) {}
+
+    l4 ([&]{trace << "unable to load " << file_;});
+
+    events_.clear ();
+    return false;
+  }
+
+  bool token_cache::
+  decode (const string& s)
+  {
+    // Key and data checksum lines.
+    //
+    size_t n (key_.size ());
+
+    if (s.size () < 2 * (n + 1) ||
+        s.compare (0, n, key_) != 0 || s[n] != '\n' || s[2 * n + 1] != '\n')
+      return false;
+
+    const char* b (s.data () + 2 * (n + 1));
+    const char* e (s.data () + s.size ());
+
+    {
+      sha256 cs;
+      cs.append (b, static_cast<size_t> (e - b));
+
+      if (s.compare (n + 1, n, cs.string ()) != 0)
+        return false;
+    }
+
+    reader r {b, e};
+
+    uint64_t c;
+    if (!r.read_uint (c) || c > static_cast<uint64_t> (e - b))
+      return false;
+
+    events_.clear ();
+    events_.reserve (static_cast<size_t> (c));
+
+    for (; c != 0; --c)
+    {
+      event v;
+
+      if (!r.read_uint (v.kind, event::raw_end + 1))
+        return false;
+
+      switch (v.kind)
+      {
+      case event::set_mode:
+        {
+          if (!r.read_uint (v.mode.v_, lexer_mode::value_next) ||
+              !r.read_uint (v.chr, 0x100))
+            return false;
+
+          break;
+        }
+      case event::get_mode:
+        {
+          if (!r.read_uint (v.mode.v_, lexer_mode::value_next))
+            return false;
+
+          break;
+        }
+      case event::expire_mode:
+        break;
+      case event::next:
+        {
+          token& t (v.tok);
+          uint64_t f;
+
+          if (!r.read_uint (v.mode.v_, lexer_mode::value_next) ||
+              !r.read_uint (t.type.v_, token_type::value_next)  ||
+              !r.read_uint (f, 0x10)                              ||
+              !r.read_string (t.value)                            ||
+              !r.read_uint (t.line)                               ||
+              !r.read_uint (t.column))
+            return false;
+
+          t.separated = (f & 0x1) != 0;
+          t.qcomp = (f & 0x2) != 0;
+          t.qtype = static_cast<quote_type> (f >> 2);
+          break;
+        }
+      case event::peek_char:
+        {
+          if (!r.read_uint (v.chr, 0x100) || !r.read_uint (v.sep, 2))
+            return false;
+
+          break;
+        }
+      case event::raw_begin:
+        {
+          if (!r.read_uint (v.tok.line))
+            return false;
+
+          break;
+        }
+      case event::raw_end:
+        {
+          if (!r.read_string (v.tok.value))
+            return false;
+
+          break;
+        }
+      }
+
+      events_.push_back (move (v));
+    }
+
+    return r.p == e;
+  }
+
+  string token_cache::
+  encode () const
+  {
+    string s;
+    write_uint (s, events_.size ());
+
+    for (const event& v: events_)
+    {
+      write_uint (s, v.kind);
+
+      switch (v.kind)
+      {
+      case event::set_mode:
+        {
+          write_uint (s, v.mode);
+          write_uint (s, static_cast<unsigned char> (v.chr));
+          break;
+        }
+      case event::get_mode:
+        {
+          write_uint (s, v.mode);
+          break;
+        }
+      case event::expire_mode:
+        break;
+      case event::next:
+        {
+          const token& t (v.tok);
+
+          write_uint (s, v.mode);
+          write_uint (s, t.type);
+          write_uint (s,
+                      (t.separated ? 0x1 : 0) |
+                      (t.qcomp ? 0x2 : 0) |
+                      (static_cast<uint64_t> (t.qtype) << 2));
+          write_string (s, t.value);
+          write_uint (s, t.line);
+          write_uint (s, t.column);
+          break;
+        }
+      case event::peek_char:
+        {
+          write_uint (s, static_cast<unsigned char> (v.chr));
+          write_uint (s, v.sep ? 1 : 0);
+          break;
+        }
+      case event::raw_begin:
+        {
+          write_uint (s, v.tok.line);
+          break;
+        }
+      case event::raw_end:
+        {
+          write_string (s, v.tok.value);
+          break;
+        }
+      }
+    }
+
+    return s;
+  }
+
+  void token_cache::
+  save ()
+  {
+    tracer trace ("token_cache::save");
+
+    if (key_.empty ())
+      return;
+
+    // If we have replayed the entire sequence, then there is nothing to
+    // update.
+    //
+    if (lexer_ == nullptr && pos_ == events_.size ())
+    {
+      stat_buildfiles_replayed.fetch_add (1, memory_order_relaxed);
+      return;
+    }
+
+    stat_buildfiles_lexed.fetch_add (1, memory_order_relaxed);
+
+    // If the parser stopped before the end of the recorded sequence, then
+    // the rest is stale.
+    //
+    events_.erase (events_.begin () + pos_, events_.end ());
+
+    string d (encode ());
+
+    // Assemble everything in memory and write it in one go to minimize the
+    // chance of a concurrent invocation seeing a partially-written file
+    // (which will be a cache miss thanks to the data checksum).
+    //
+    string s (key_);
+    s += '\n';
+    {
+      sha256 cs;
+      cs.append (d.data (), d.size ());
+      s += cs.string ();
+    }
+    s += '\n';
+    s += d;
+
+    try
+    {
+      try_mkdir_p (file_.directory ());
+
+      ofdstream ofs (fdopen (file_,
+                             fdopen_mode::out      | fdopen_mode::binary |
+                             fdopen_mode::truncate | fdopen_mode::create));
+      ofs.write (s.data (), static_cast<streamsize> (s.size ()));
+      ofs.close ();
+
+      l5 ([&]{trace << "saved " << file_ << " for " << name_;});
+    }
+    catch (const io_error& e)
+    {
+      l4 ([&]{trace << "unable to write to " << file_ << ": " << e;});
+    }
+    catch (const system_error& e)
+    {
+      l4 ([&]{trace << "unable to create " << file_.directory () << ": "
+                    << e;});
+    }
+  }
+}
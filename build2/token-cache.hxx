@@ -0,0 +1,158 @@
+// file      : build2/token-cache.hxx -*- C++ -*-
+// copyright : Copyright (c) 2014-2019 Code Synthesis Ltd
+// license   : MIT; see accompanying LICENSE file
+
+#ifndef BUILD2_TOKEN_CACHE_HXX
+#define BUILD2_TOKEN_CACHE_HXX
+
+#include <build2/types.hxx>
+#include <build2/utility.hxx>
+
+#include <build2/token.hxx>
+#include <build2/lexer.hxx>
+
+namespace build2
+{
+  // Persistent buildfile token stream cache.
+  //
+  // Lexing is a noticeable part of loading a project with many buildfiles.
+  // To avoid re-lexing buildfiles that haven't changed since the last build
+  // system invocation we save the sequence of the parser's interactions
+  // with the lexer (mode changes, tokens, etc) in the project's
+  // out_root/build/tokens/ directory (removed by disfigure) and replay it
+  // instead of lexing on the next load. The cache is only used if the
+  // project is configured (out_root/build/config.build exists).
+  //
+  // Note that we cannot just save the tokens: what the lexer produces
+  // depends on the modes set by the parser which in turn may depend on the
+  // values of variables (for example, in the if-else branch that is not
+  // taken we merely skip tokens). However, the lexer is a pure function of
+  // its input and the sequence of calls made by the parser. So as long as
+  // the buildfile hasn't changed (as determined by its path and contents
+  // checksum as well as the build system version) and the parser repeats
+  // the recorded calls, the recorded results are valid. As soon as
+  // the parser makes a different call, we switch to the real lexer, bring it
+  // to the same state by re-executing the calls made so far, continue lexing
+  // normally, and save the updated sequence at the end.
+  //
+  // Also, the constructs that need access to the raw character sequence
+  // (currently only for-loop bodies) save it with raw_begin()/raw_end()
+  // which is recorded and replayed as any other call.
+  //
+  // Any error or mismatch when loading the cache entry is treated as a cache
+  // miss and the entry is silently overwritten on save.
+  //
+  class token_cache
+  {
+  public:
+    // If out_root is NULL or the buildfile cannot be identified (for
+    // example, it is stdin), then the cache is disabled and the calls are
+    // simply forwarded to the lexer.
+    //
+    token_cache (istream&, const path& name, const dir_path* out_root);
+
+    // Save the updated sequence, if necessary. Should only be called after
+    // successfully parsing the entire buildfile.
+    //
+    void
+    save ();
+
+    // The lexer interface used by the parser (see lexer for details).
+    //
+    void
+    mode (lexer_mode, char pair_separator);
+
+    lexer_mode
+    mode ();
+
+    void
+    expire_mode ();
+
+    // Return the token together with the mode it was lexed in (see
+    // parser::lexer_next()).
+    //
+    pair<token, lexer_mode>
+    next ();
+
+    pair<char, bool>
+    peek_char ();
+
+    // Start saving the raw character sequence that comprises the tokens
+    // returned by subsequent next() calls (see lexer::save_guard) and
+    // return the line of the first character to be saved.
+    //
+    uint64_t
+    raw_begin ();
+
+    // Stop saving and return the saved character sequence.
+    //
+    string
+    raw_end ();
+
+  private:
+    struct event
+    {
+      enum kind_type: uint8_t
+      {
+        set_mode,
+        get_mode,
+        expire_mode,
+        next,
+        peek_char,
+        raw_begin,
+        raw_end
+      };
+
+      kind_type  kind = set_mode;
+      lexer_mode mode;          // set_mode, get_mode, next
+      char       chr = '\0';    // set_mode (pair separator), peek_char
+      bool       sep = false;   // peek_char
+      token      tok;           // next, raw_begin (line), raw_end (value)
+    };
+
+    // Return the next recorded event if it is of the specified kind and the
+    // predicate (if any) is satisfied. Otherwise, switch to the real lexer
+    // and return NULL.
+    //
+    template <typename F>
+    const event*
+    replay (event::kind_type, F&&);
+
+    void
+    record (event&&);
+
+    void
+    start_raw ();
+
+    // Switch to the real lexer, if not already, and return it.
+    //
+    lexer&
+    live ();
+
+    bool
+    load ();
+
+    bool
+    decode (const string&);
+
+    string
+    encode () const;
+
+  private:
+    istream&    is_;
+    const path& name_;
+
+    string key_;  // Empty if the cache is disabled.
+    path   file_; // Cache entry file.
+
+    vector<event> events_;
+    size_t        pos_ = 0; // Next event to replay.
+
+    unique_ptr<lexer> lexer_; // NULL while replaying.
+
+    string                        raw_;       // Raw characters being saved.
+    unique_ptr<lexer::save_guard> raw_guard_; // Not NULL while saving.
+  };
+}
+
+#endif // BUILD2_TOKEN_CACHE_HXX
@@ -1289,6 +1289,21 @@ namespace build2
     return r;
   }
 
+  const variable& variable_pool::
+  insert_slot (string n,
+               const build2::value_type* t,
+               const variable_visibility* v)
+  {
+    bool e (find (n) != nullptr);
+
+    variable& r (insert (move (n), t, v));
+
+    if (!e && r.alias == &r && slots_ != max_slots)
+      r.slot = ++slots_;
+
+    return r;
+  }
+
   const variable& variable_pool::
   insert_alias (const variable& var, string n)
   {
@@ -1391,6 +1406,20 @@ namespace build2
   find (const variable& var, bool typed) const ->
     pair<const value_data*, const variable&>
   {
+    // Fast slot. Note that values of aliases are only found under their
+    // own variables so we fall back to the general lookup if there are any.
+    //
+    if (var.slot != 0 && var.alias == &var)
+    {
+      size_t i (var.slot - 1);
+      const value_data* r (i < slots_.size () ? slots_[i] : nullptr);
+
+      if (r != nullptr && typed && var.type != nullptr)
+        typify (*r, var);
+
+      return pair<const value_data*, const variable&> (r, var);
+    }
+
     const variable* v (&var);
     const value_data* r (nullptr);
     do
@@ -1440,6 +1469,9 @@ namespace build2
     auto p (m_.emplace (var, value_data (typed ? var.type : nullptr)));
     value_data& r (p.first->second);
 
+    if (p.second && var.slot != 0)
+      index (var, r);
+
     if (!p.second)
     {
       // Check if this is the first access after being assigned a type.
@@ -1452,9 +1484,155 @@ namespace build2
 
     r.version++;
 
+    if (global_)
+      variable_generation++;
+
     return make_pair (reference_wrapper<value> (r), p.second);
   }
 
+  void variable_map::
+  index (const variable& var, value_data& v)
+  {
+    size_t i (var.slot - 1);
+
+    if (i >= slots_.size ())
+      slots_.resize (i + 1, nullptr);
+
+    slots_[i] = &v;
+  }
+
+  void variable_map::
+  reindex ()
+  {
+    slots_.clear ();
+
+    for (auto& p: m_)
+    {
+      const variable& var (p.first);
+
+      if (var.slot != 0)
+        index (var, p.second);
+    }
+  }
+
+  // variable_pattern_map
+  //
+  void variable_pattern_map::
+  compile () const
+  {
+    patterns_.clear ();
+
+    for (auto i (map_.rbegin ()); i != map_.rend (); ++i)
+    {
+      const string& p (i->first);
+
+      // Note that we treat everything that could be part of a wildcard or
+      // a bracket expression as such. This can only make the literal
+      // prefix/suffix shorter.
+      //
+      const char* wc ("*?[]");
+
+      size_t b (p.find_first_of (wc));
+      size_t e (p.find_last_of (wc));
+
+      pattern c {&p, &i->second, 0, 0, false};
+
+      if (b == string::npos) // No wildcards (exact name).
+        c.prefix = p.size ();
+      else
+      {
+        c.prefix = b;
+        c.suffix = p.size () - e - 1;
+        c.simple = (b == e && p[b] == '*');
+      }
+
+      patterns_.push_back (c);
+    }
+
+    compiled_ = true;
+  }
+
+  bool variable_pattern_map::
+  match (const pattern& p, const string& n) const
+  {
+    const string& t (*p.text);
+
+    if (n.size () < p.prefix + p.suffix)
+      return false;
+
+    // Compare the literal prefix and suffix the same way as path_match()
+    // does (case-insensitively on Windows).
+    //
+    using traits = path::traits;
+
+    if (traits::compare (t.c_str (), p.prefix, n.c_str (), p.prefix) != 0)
+      return false;
+
+    if (traits::compare (t.c_str () + t.size () - p.suffix, p.suffix,
+                         n.c_str () + n.size () - p.suffix, p.suffix) != 0)
+      return false;
+
+    if (p.simple)
+      return true;
+
+    if (p.prefix == t.size ()) // No wildcards.
+      return n.size () == t.size ();
+
+    return n.size () >= t.size () - 1 && // One for '*' or '?'.
+      butl::path_match (t, n);
+  }
+
+  auto variable_pattern_map::
+  match (const string& n) const -> const vector<const variable_map*>&
+  {
+    // During the load phase (which is exclusive) we don't need to lock.
+    //
+    shared_mutex* m (
+      phase != run_phase::load
+      ? &variable_cache_mutex_shard[
+          hash<const variable_pattern_map*> () (this) %
+          variable_cache_mutex_shard_size]
+      : nullptr);
+
+    {
+      slock l;
+      if (m != nullptr)
+        l = slock (*m);
+
+      if (compiled_)
+      {
+        auto i (matches_.find (n));
+        if (i != matches_.end ())
+          return i->second;
+      }
+    }
+
+    ulock l;
+    if (m != nullptr)
+      l = ulock (*m);
+
+    // Someone could have beaten us to it.
+    //
+    auto i (matches_.find (n));
+    if (compiled_ && i != matches_.end ())
+      return i->second;
+
+    if (!compiled_)
+      compile ();
+
+    vector<const variable_map*> r;
+    for (const pattern& p: patterns_)
+    {
+      if (match (p, n))
+        r.push_back (p.vars);
+    }
+
+    stat_pattern_tests.fetch_add (patterns_.size (), memory_order_relaxed);
+    stat_pattern_matches.fetch_add (r.size (), memory_order_relaxed);
+
+    return matches_.emplace (n, move (r)).first->second;
+  }
+
   // variable_type_map
   //
   lookup variable_type_map::
@@ -1471,34 +1649,18 @@ namespace build2
       if (i == end ())
         continue;
 
-      // Try to match the pattern, starting from the longest values
-      // so that the more "specific" patterns (i.e., those that cover
-      // fewer characters with the wildcard) take precedence. See
-      // tests/variable/type-pattern.
+      //@@ TODO: should we detect ambiguity? 'foo-*' '*-foo' and 'foo-foo'?
+      //   Right now the last defined will be used.
       //
-      const variable_pattern_map& m (i->second);
-
-      for (auto j (m.rbegin ()); j != m.rend (); ++j)
+      for (const variable_map* pvm: i->second.match (name))
       {
-        const string& pat (j->first);
-
-        //@@ TODO: should we detect ambiguity? 'foo-*' '*-foo' and 'foo-foo'?
-        //   Right now the last defined will be used.
-        //
-        if (pat != "*")
-        {
-          if (name.size () < pat.size () - 1 || // One for '*' or '?'.
-              !butl::path_match (pat, name))
-            continue;
-        }
-
         // Ok, this pattern matches. But is there a variable?
         //
         // Since we store append/prepend values untyped, instruct find() not
         // to automatically type it. And if it is assignment, then typify it
         // ourselves.
         //
-        const variable_map& vm (j->second);
+        const variable_map& vm (*pvm);
         {
           auto p (vm.find (var, false));
           if (const variable_map::value_data* v = p.first)
@@ -1519,4 +1681,6 @@ namespace build2
 
   size_t variable_cache_mutex_shard_size;
   unique_ptr<shared_mutex[]> variable_cache_mutex_shard;
+
+  size_t variable_generation;
 }
@@ -177,6 +177,7 @@ namespace build2
     const value_type* type;              // If NULL, then not (yet) typed.
     unique_ptr<const variable> override;
     variable_visibility visibility;
+    size_t slot = 0;                     // Fast slot + 1 or 0 if none.
 
     // Return true if this variable is an alias of the specified variable.
     //
@@ -1012,6 +1013,31 @@ namespace build2
         move (name), &value_traits<T>::value_type, &v, &overridable);
     }
 
+    // Insert a variable that is looked up in variable_map via a fast slot
+    // rather than by name (see variable_map::find() for details). This is
+    // meant for hot, well-known variables that rules look up on every
+    // target and is normally done by modules when entering their variables.
+    //
+    // Only a newly inserted variable can be assigned a slot (an existing
+    // one may already have values that are not indexed). If that's not the
+    // case or all the slots are taken, then this is equivalent to insert().
+    //
+    template <typename T>
+    const variable&
+    insert_slot (string name)
+    {
+      return insert_slot (move (name), &value_traits<T>::value_type, nullptr);
+    }
+
+    template <typename T>
+    const variable&
+    insert_slot (string name, variable_visibility v)
+    {
+      return insert_slot (move (name), &value_traits<T>::value_type, &v);
+    }
+
+    static const size_t max_slots = 64;
+
     // Alias an existing variable with a new name.
     //
     // Aliasing is purely a lookup-level mechanism. That is, when variable_map
@@ -1078,7 +1104,7 @@ namespace build2
 
   public:
     void
-    clear () {map_.clear ();}
+    clear () {map_.clear (); slots_ = 0;}
 
     variable_pool (): variable_pool (false) {}
 
@@ -1104,6 +1130,11 @@ namespace build2
             const bool* overridable = nullptr,
             bool pattern = true);
 
+    const variable&
+    insert_slot (string name,
+                 const value_type*,
+                 const variable_visibility*);
+
     void
     update (variable&,
             const value_type*,
@@ -1143,6 +1174,7 @@ namespace build2
     }
 
     map map_;
+    size_t slots_ = 0; // Number of assigned slots.
 
     // Patterns.
     //
@@ -1216,6 +1248,14 @@ namespace butl
 
 namespace build2
 {
+  // Incremented on each modification of a global variable map (scope
+  // variables, target type/pattern-specific variables, etc). Since such
+  // maps can only be modified during the load phase, this number stays the
+  // same during match and execute and can be used to validate lookup
+  // results memoized across phases (see target::find_memoized()).
+  //
+  extern size_t variable_generation;
+
   class variable_map
   {
   public:
@@ -1301,6 +1341,10 @@ namespace build2
       assert (l.vars == this);
       value& r (const_cast<value&> (*l.value));
       static_cast<value_data&> (r).version++;
+
+      if (global_)
+        variable_generation++;
+
       return r;
     }
 
@@ -1355,8 +1399,28 @@ namespace build2
     explicit
     variable_map (bool global = false): global_ (global) {}
 
+    // The slots index points into the map so it has to be rebuilt on copy.
+    //
+    variable_map (const variable_map& m)
+        : global_ (m.global_), m_ (m.m_) {reindex ();}
+
+    variable_map&
+    operator= (const variable_map& m)
+    {
+      if (this != &m)
+      {
+        global_ = m.global_;
+        m_ = m.m_;
+        reindex ();
+      }
+      return *this;
+    }
+
+    variable_map (variable_map&&) = default;
+    variable_map& operator= (variable_map&&) = default;
+
     void
-    clear () {m_.clear ();}
+    clear () {m_.clear (); slots_.clear ();}
 
   private:
     friend class variable_type_map;
@@ -1364,9 +1428,21 @@ namespace build2
     void
     typify (const value_data&, const variable&) const;
 
+    void
+    index (const variable&, value_data&);
+
+    void
+    reindex ();
+
   private:
     bool global_;
     map_type m_;
+
+    // Values of the variables with fast slots (see
+    // variable_pool::insert_slot()) indexed by slot - 1. NULL if there is
+    // no value for the variable in this map.
+    //
+    vector<value_data*> slots_;
   };
 
   // Value caching. Used for overrides as well as target type/pattern-specific
@@ -1386,6 +1462,31 @@ namespace build2
   extern size_t variable_cache_mutex_shard_size;
   extern unique_ptr<shared_mutex[]> variable_cache_mutex_shard;
 
+  // Hash functions for the variable_cache keys.
+  //
+  struct variable_cache_hash
+  {
+    static size_t
+    combine (size_t s, size_t h)
+    {
+      return s ^ (h + 0x9e3779b9 + (s << 6) + (s >> 2));
+    }
+
+    size_t
+    operator() (const pair<const variable*, const variable_map*>& k) const
+    {
+      return combine (hash<const variable*> () (k.first),
+                      hash<const variable_map*> () (k.second));
+    }
+
+    size_t
+    operator() (const pair<const value*, const value*>& k) const
+    {
+      return combine (hash<const value*> () (k.first),
+                      hash<const value*> () (k.second));
+    }
+  };
+
   template <typename K>
   class variable_cache
   {
@@ -1397,9 +1498,21 @@ namespace build2
     pair<value&, ulock>
     insert (K, const lookup& stem, size_t version, const variable&);
 
+  public:
+    variable_cache () = default;
+
+    // Note: not thread-safe (only used to move the containing scope into
+    // the scope map).
+    //
+    variable_cache (variable_cache&&);
+    variable_cache& operator= (variable_cache&&) = delete;
+
   private:
     struct entry_type
     {
+      const K      key;
+      const size_t hash;
+
       // Note: we use value_data instead of value since the result is often
       // returned as lookup. We also maintain the version in case one cached
       // value (e.g., override) is based on another (e.g., target
@@ -1407,31 +1520,61 @@ namespace build2
       //
       variable_map::value_data value;
 
-      size_t version = 0; // Version on which this value is based.
+      // Version on which this value is based.
+      //
+      atomic<size_t> version;
 
       // Location of the stem as well as the version on which this cache
       // value is based. Used to track the location and value of the stem
       // for cache invalidation. NULL/0 means there is no stem.
       //
-      const variable_map* stem_vars = nullptr;
-      size_t              stem_version = 0;
+      atomic<const variable_map*> stem_vars;
+      atomic<size_t>              stem_version;
 
-      // For GCC 4.9.
+      // True if the value can be used without locking. Cleared when the
+      // value is being (re)calculated by the thread holding the exclusive
+      // lock and set again by the first shared lookup that finds the entry
+      // valid (which means the calculation is complete).
       //
-      entry_type () = default;
-      entry_type (variable_map::value_data val,
-                  size_t ver,
-                  const variable_map* svars,
-                  size_t sver)
-          : value (move (val)),
-            version (ver),
-            stem_vars (svars),
-            stem_version (sver) {}
+      atomic<bool> valid {false};
+
+      // The value type as of the time the entry was last marked valid. Used
+      // by the lock-free lookups which cannot examine the value itself since
+      // it can be concurrently retyped by the thread holding the exclusive
+      // lock.
+      //
+      atomic<const value_type*> type {nullptr};
+
+      entry_type (K k, size_t h,
+                  size_t ver, const variable_map* svars, size_t sver)
+          : key (move (k)), hash (h),
+            value (nullptr),
+            version (ver), stem_vars (svars), stem_version (sver) {}
+    };
+
+    // Open-addressing hash table (linear probing, load factor of at most
+    // 1/2) of entry pointers. Lookups of valid entries are lock-free while
+    // insertions and invalidations are done under the exclusive lock.
+    //
+    // The entries are never removed or moved so we can return references
+    // to their values. When the table is grown, the old one is retired but
+    // kept around since concurrent lookups may still be probing it.
+    //
+    struct table_type
+    {
+      size_t                            mask; // Capacity - 1.
+      unique_ptr<atomic<entry_type*>[]> slots;
     };
 
-    using map_type = std::map<K, entry_type>;
+    static entry_type*
+    find (const table_type*, const K&, size_t);
 
-    map_type m_;
+    void
+    enter (entry_type&); // Under exclusive lock.
+
+    atomic<table_type*>            table_ {nullptr};
+    vector<unique_ptr<table_type>> tables_;  // Current and retired.
+    vector<unique_ptr<entry_type>> entries_;
   };
 
   // Target type/pattern-specific variables.
@@ -1449,7 +1592,16 @@ namespace build2
     variable_map&
     operator[] (const string& v)
     {
-      return map_.emplace (v, variable_map (global_)).first->second;
+      auto p (map_.emplace (v, variable_map (global_)));
+
+      if (p.second) // New pattern.
+      {
+        compiled_ = false;
+        patterns_.clear ();
+        matches_.clear ();
+      }
+
+      return p.first->second;
     }
 
     const_iterator         begin ()  const {return map_.begin ();}
@@ -1458,9 +1610,49 @@ namespace build2
     const_reverse_iterator rend ()   const {return map_.rend ();}
     bool                   empty ()  const {return map_.empty ();}
 
+    // Return the variable maps of the patterns that match the target name
+    // in the order of precedence, that is, starting from the longest
+    // pattern so that the more "specific" patterns (i.e., those that cover
+    // fewer characters with the wildcard) take precedence. See
+    // tests/variable/type-pattern.
+    //
+    // The patterns are compiled on first use into their literal prefixes
+    // and suffixes which are sufficient to match the common single-'*'
+    // patterns and otherwise rule out most names before falling back to
+    // path_match(). The result is also cached per target name so that
+    // subsequent lookups of other variables for the same target do not
+    // have to test the patterns again.
+    //
+    const vector<const variable_map*>&
+    match (const string& name) const;
+
+  private:
+    struct pattern
+    {
+      const string*       text;
+      const variable_map* vars;
+      size_t              prefix; // Length of the literal prefix.
+      size_t              suffix; // Length of the literal suffix.
+      bool                simple; // Single '*' wildcard.
+    };
+
+    void
+    compile () const;
+
+    bool
+    match (const pattern&, const string&) const;
+
   private:
     bool global_;
     map_type map_;
+
+    // Compiled patterns (in the order of precedence) and the match cache.
+    // Only modified during the load phase or under the exclusive lock of
+    // the variable_cache_mutex_shard.
+    //
+    mutable bool compiled_ = false;
+    mutable vector<pattern> patterns_;
+    mutable std::unordered_map<string, vector<const variable_map*>> matches_;
   };
 
   class variable_type_map
@@ -1490,13 +1682,20 @@ namespace build2
     //
     // The key is the combination of the "original value identity" (as a
     // pointer to the value in one of the variable_pattern_map's) and the
-    // "target identity" (as target type and target name). Note that while at
-    // first it may seem like we don't need the target identity, we actually
-    // do since the stem may itself be target-type/pattern-specific. See
+    // "stem identity" (as a pointer to the stem value or NULL if there is
+    // none). Note that the stem may itself be target type/pattern-specific
+    // (including a cached prepend/append) in which case its identity will
+    // be different for the targets that it applies to. See
     // scope::find_original() for details.
     //
+    // Keying on the stem rather than on the target identity (as target type
+    // and name) means that the targets matching the same pattern and having
+    // the same stem (normally the scope's value) share a single cached
+    // value rather than each having its own copy of what is often a long
+    // list of options.
+    //
     mutable
-    variable_cache<tuple<const value*, const target_type*, string>>
+    variable_cache<pair<const value*, const value*>>
     cache;
 
   private:
@@ -585,6 +585,83 @@ namespace build2
 
   // variable_cache
   //
+  template <typename K>
+  variable_cache<K>::
+  variable_cache (variable_cache&& c)
+      : table_ (c.table_.load (memory_order_relaxed)),
+        tables_ (move (c.tables_)),
+        entries_ (move (c.entries_))
+  {
+    c.table_.store (nullptr, memory_order_relaxed);
+  }
+
+  template <typename K>
+  auto variable_cache<K>::
+  find (const table_type* t, const K& k, size_t h) -> entry_type*
+  {
+    if (t != nullptr)
+    {
+      // There is always an empty slot so this terminates.
+      //
+      for (size_t i (h & t->mask); ; i = (i + 1) & t->mask)
+      {
+        entry_type* e (t->slots[i].load (memory_order_acquire));
+
+        if (e == nullptr)
+          break;
+
+        if (e->hash == h && e->key == k)
+          return e;
+      }
+    }
+
+    return nullptr;
+  }
+
+  template <typename K>
+  void variable_cache<K>::
+  enter (entry_type& e)
+  {
+    table_type* t (table_.load (memory_order_relaxed));
+
+    // Grow the table if the load factor would exceed 1/2. Note that we
+    // have to populate the new table before publishing it.
+    //
+    size_t n (entries_.size ()); // Including this entry.
+
+    if (t == nullptr || n * 2 > t->mask + 1)
+    {
+      size_t c (t != nullptr ? (t->mask + 1) * 2 : 16);
+
+      unique_ptr<table_type> nt (
+        new table_type {c - 1, unique_ptr<atomic<entry_type*>[]> (
+                                 new atomic<entry_type*>[c])});
+
+      for (size_t i (0); i != c; ++i)
+        nt->slots[i].store (nullptr, memory_order_relaxed);
+
+      for (const unique_ptr<entry_type>& p: entries_)
+      {
+        size_t i (p->hash & nt->mask);
+        for (; nt->slots[i].load (memory_order_relaxed) != nullptr;
+             i = (i + 1) & nt->mask) ;
+
+        nt->slots[i].store (p.get (), memory_order_relaxed);
+      }
+
+      t = nt.get ();
+      tables_.push_back (move (nt));
+      table_.store (t, memory_order_release);
+      return; // This entry is already in entries_.
+    }
+
+    size_t i (e.hash & t->mask);
+    for (; t->slots[i].load (memory_order_relaxed) != nullptr;
+         i = (i + 1) & t->mask) ;
+
+    t->slots[i].store (&e, memory_order_release);
+  }
+
   template <typename K>
   pair<value&, ulock> variable_cache<K>::
   insert (K k, const lookup& stem, size_t ver, const variable& var)
@@ -596,6 +673,43 @@ namespace build2
                  ? static_cast<const value_data*> (stem.value)->version
                  : 0);
 
+    size_t h (variable_cache_hash () (k));
+
+    auto hit = [ver, svars, sver, &var] (const entry_type& e,
+                                         const value_type* t)
+    {
+      return (e.version.load (memory_order_relaxed) == ver          &&
+              e.stem_vars.load (memory_order_relaxed) == svars      &&
+              e.stem_version.load (memory_order_relaxed) == sver    &&
+              (var.type == nullptr || t == var.type));
+    };
+
+    // Lock-free lookup. This is the common case once the cache has been
+    // populated.
+    //
+    // Without a lock we cannot examine the value itself (in particular, its
+    // type) since it can be concurrently recalculated or retyped by the
+    // thread holding the exclusive lock. So we use the type as of the time
+    // the entry was marked valid and, if it doesn't match, fall through to
+    // the locked lookup (which will retype the value). We also re-check the
+    // valid flag after examining the entry (similar to a seqlock) so that we
+    // don't return an entry that was invalidated half-way through. Note,
+    // however, that, as with the locked lookup, the returned reference is
+    // only safe to use because the cached values are not invalidated while
+    // in use (the values they are based on only change during load).
+    //
+    if (entry_type* e = find (table_.load (memory_order_acquire), k, h))
+    {
+      if (e->valid.load (memory_order_acquire) &&
+          hit (*e, e->type.load (memory_order_relaxed)))
+      {
+        std::atomic_thread_fence (memory_order_acquire);
+
+        if (e->valid.load (memory_order_relaxed))
+          return pair<value&, ulock> (e->value, ulock ());
+      }
+    }
+
     shared_mutex& m (
       variable_cache_mutex_shard[
         hash<variable_cache*> () (this) % variable_cache_mutex_shard_size]);
@@ -603,16 +717,21 @@ namespace build2
     slock sl (m);
     ulock ul (m, defer_lock);
 
-    auto i (m_.find (k));
+    entry_type* e (find (table_.load (memory_order_relaxed), k, h));
 
-    // Cache hit.
+    // Cache hit. Since we have the shared lock, nobody can be calculating
+    // the value so we can (re)mark it as valid for lock-free lookups.
     //
-    if (i != m_.end ()                 &&
-        i->second.version == ver       &&
-        i->second.stem_vars == svars   &&
-        i->second.stem_version == sver &&
-        (var.type == nullptr || i->second.value.type == var.type))
-      return pair<value&, ulock> (i->second.value, move (ul));
+    if (e != nullptr && hit (*e, e->value.type))
+    {
+      if (!e->valid.load (memory_order_relaxed))
+      {
+        e->type.store (e->value.type, memory_order_relaxed);
+        e->valid.store (true, memory_order_release);
+      }
+
+      return pair<value&, ulock> (e->value, move (ul));
+    }
 
     // Relock for exclusive access. Note that it is entirely possible
     // that between unlock and lock someone else has updated the entry.
@@ -620,51 +739,68 @@ namespace build2
     sl.unlock ();
     ul.lock ();
 
-    // Note that the cache entries are never removed so we can reuse the
-    // iterator.
+    // Note that the cache entries are never removed so we only need to
+    // look again if there was no entry.
     //
-    pair<typename map_type::iterator, bool> p (i, i == m_.end ());
+    bool miss (false);
+    if (e == nullptr)
+    {
+      e = find (table_.load (memory_order_relaxed), k, h);
 
-    if (p.second)
-      p = m_.emplace (move (k),
-                      entry_type {value_data (nullptr), ver, svars, sver});
+      if ((miss = (e == nullptr)))
+      {
+        entries_.push_back (
+          unique_ptr<entry_type> (
+            new entry_type (move (k), h, ver, svars, sver)));
 
-    entry_type& e (p.first->second);
+        e = entries_.back ().get ();
+        enter (*e);
+      }
+    }
 
-    if (p.second)
+    if (miss)
     {
       // Cache miss.
       //
-      e.value.version++; // New value.
+      e->value.version++; // New value.
     }
-    else if (e.version != ver     ||
-             e.stem_vars != svars ||
-             e.stem_version != sver)
+    else if (e->version.load (memory_order_relaxed) != ver     ||
+             e->stem_vars.load (memory_order_relaxed) != svars ||
+             e->stem_version.load (memory_order_relaxed) != sver)
     {
-      // Cache invalidation.
+      // Cache invalidation. Mark the entry invalid before changing anything
+      // (see the lock-free lookup above).
       //
-      assert (e.version <= ver);
-      e.version = ver;
+      e->valid.store (false, memory_order_relaxed);
+      std::atomic_thread_fence (memory_order_release);
+
+      assert (e->version.load (memory_order_relaxed) <= ver);
+      e->version.store (ver, memory_order_relaxed);
 
-      if (e.stem_vars != svars)
-        e.stem_vars = svars;
+      if (e->stem_vars.load (memory_order_relaxed) != svars)
+        e->stem_vars.store (svars, memory_order_relaxed);
       else
-        assert (e.stem_version <= sver);
+        assert (e->stem_version.load (memory_order_relaxed) <= sver);
 
-      e.stem_version = sver;
+      e->stem_version.store (sver, memory_order_relaxed);
 
-      e.value.version++; // Value changed.
+      e->value.version++; // Value changed.
     }
     else
     {
       // Cache hit.
       //
-      if (var.type != nullptr && e.value.type != var.type)
-        typify (e.value, *var.type, &var);
+      if (var.type != nullptr && e->value.type != var.type)
+      {
+        e->valid.store (false, memory_order_relaxed);
+        std::atomic_thread_fence (memory_order_release);
+
+        typify (e->value, *var.type, &var);
+      }
 
       ul.unlock ();
     }
 
-    return pair<value&, ulock> (e.value, move (ul));
+    return pair<value&, ulock> (e->value, move (ul));
   }
 }
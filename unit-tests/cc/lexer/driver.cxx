@@ -2,12 +2,15 @@
 // copyright : Copyright (c) 2014-2019 Code Synthesis Ltd
 // license   : MIT; see accompanying LICENSE file
 
+#include <chrono>
 #include <cassert>
 #include <iostream>
 
 #include <build2/types.hxx>
 #include <build2/utility.hxx>
 
+#include <build2/filesystem.hxx> // path_entry()
+
 #include <build2/cc/lexer.hxx>
 
 using namespace std;
@@ -17,12 +20,62 @@ namespace build2
 {
   namespace cc
   {
-    // Usage: argv[0] [-l] [<file>]
+    // Lex the file the specified number of times and print the number of
+    // tokens, the checksum, and the throughput. This is a microbenchmark for
+    // the lexer's direct buffer scans and is not run as part of the tests.
+    //
+    static int
+    bench (const char* file, uint64_t n)
+    {
+      using namespace chrono;
+
+      uint64_t ts (0); // Tokens.
+      uint64_t bs (0); // Bytes.
+      string cs;
+
+      // Note that we cannot use the stream position since it is -1 after
+      // reaching eof.
+      //
+      uint64_t fs (path_entry (path (file), true).second.size);
+
+      steady_clock::time_point start (steady_clock::now ());
+
+      for (uint64_t i (0); i != n; ++i)
+      {
+        ifdstream is (file);
+        lexer l (is, path (file));
+
+        for (token t; l.next (t) != token_type::eos; )
+          ++ts;
+
+        bs += fs;
+        cs = l.checksum ();
+      }
+
+      duration<double> d (steady_clock::now () - start);
+
+      cout << "tokens   " << ts / n << endl
+           << "checksum " << cs << endl
+           << "time     " << d.count () * 1000 / n << " ms" << endl
+           << "speed    " << bs / d.count () / (1024 * 1024) << " MB/s"
+           << endl;
+
+      return 0;
+    }
+
+    // Usage: argv[0] [-l] [-c] [<file>]
+    //        argv[0] -b <iterations> <file>
+    //
+    // -l  print token locations
+    // -c  print checksum after the tokens
+    // -b  benchmark (see bench() above)
     //
     int
     main (int argc, char* argv[])
     {
       bool loc (false);
+      bool sum (false);
+      uint64_t iters (0);
       const char* file (nullptr);
 
       for (int i (1); i != argc; ++i)
@@ -31,6 +84,10 @@ namespace build2
 
         if (a == "-l")
           loc = true;
+        else if (a == "-c")
+          sum = true;
+        else if (a == "-b" && i + 1 != argc)
+          iters = stoull (argv[++i]);
         else
         {
           file = argv[i];
@@ -40,6 +97,12 @@ namespace build2
 
       try
       {
+        if (iters != 0)
+        {
+          assert (file != nullptr);
+          return bench (file, iters);
+        }
+
         ifdstream is;
         if (file != nullptr)
           is.open (file);
@@ -62,6 +125,9 @@ namespace build2
 
           cout << endl;
         }
+
+        if (sum)
+          cout << l.checksum () << endl;
       }
       catch (const failed&)
       {
@@ -42,8 +42,13 @@ namespace build2
         translation_unit u (p.parse (is, path (file)));
 
         for (const module_import& m: u.mod.imports)
+        {
+          bool q (m.type == import_type::module_header && m.name[0] != '<');
+
           cout << (m.exported ? "export " : "")
-               << "import " << m.name << ';' << endl;
+               << "import " << (q ? "\"" : "") << m.name << (q ? "\"" : "")
+               << ';' << endl;
+        }
 
         if (!u.mod.name.empty ())
           cout << (u.mod.iface ? "export " : "")
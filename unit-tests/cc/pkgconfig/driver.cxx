@@ -0,0 +1,218 @@
+// file      : unit-tests/cc/pkgconfig/driver.cxx -*- C++ -*-
+// copyright : Copyright (c) 2014-2019 Code Synthesis Ltd
+// license   : MIT; see accompanying LICENSE file
+
+#include <libpkgconf/libpkgconf.h>
+
+#include <cassert>
+#include <iostream>
+
+#include <build2/types.hxx>
+#include <build2/utility.hxx>
+
+#include <build2/cc/pkgconfig-reader.hxx>
+
+// See build2/cc/pkgconfig.cxx for details.
+//
+namespace details
+{
+  void*
+  pkgconf_cross_personality_default (); // Never called.
+}
+
+using namespace details;
+
+template <typename H>
+static inline pkgconf_client_t*
+call_pkgconf_client_new (pkgconf_client_t* (*f) (H, void*),
+                         H error_handler,
+                         void* error_handler_data)
+{
+  return f (error_handler, error_handler_data);
+}
+
+template <typename H, typename P>
+static inline pkgconf_client_t*
+call_pkgconf_client_new (pkgconf_client_t* (*f) (H, void*, P),
+                         H error_handler,
+                         void* error_handler_data)
+{
+  return f (error_handler,
+            error_handler_data,
+            ::pkgconf_cross_personality_default ());
+}
+
+using namespace std;
+using namespace butl;
+
+namespace build2
+{
+  namespace cc
+  {
+    static bool
+    error_handler (const char* msg, const pkgconf_client_t*, const void*)
+    {
+      cerr << msg;
+      return true;
+    }
+
+    // Extract Cflags or Libs with libpkgconf (without filtering out the
+    // system directories).
+    //
+    static strings
+    extract (pkgconf_client_t* c, pkgconf_pkg_t* p, bool cflags, bool stat)
+    {
+      pkgconf_client_set_flags (
+        c,
+        PKGCONF_PKG_PKGF_SIMPLIFY_ERRORS |
+        (stat
+         ? PKGCONF_PKG_PKGF_SEARCH_PRIVATE |
+           PKGCONF_PKG_PKGF_MERGE_PRIVATE_FRAGMENTS
+         : 0));
+
+      pkgconf_list_t l = PKGCONF_LIST_INITIALIZER;
+      int e (cflags
+             ? pkgconf_pkg_cflags (c, p, &l, 100)
+             : pkgconf_pkg_libs (c, p, &l, 100));
+      assert (e == PKGCONF_PKG_ERRF_OK);
+
+      strings r;
+
+      pkgconf_node_t* n;
+      PKGCONF_FOREACH_LIST_ENTRY(l.head, n)
+      {
+        auto f (static_cast<const pkgconf_fragment_t*> (n->data));
+
+        string s;
+        if (f->type != '\0')
+        {
+          s += '-';
+          s += f->type;
+        }
+
+        s += f->data;
+        r.push_back (move (s));
+      }
+
+      pkgconf_fragment_free (&l);
+      return r;
+    }
+
+    static strings
+    concat (const strings& x, const strings* y)
+    {
+      strings r (x);
+
+      if (y != nullptr)
+        r.insert (r.end (), y->begin (), y->end ());
+
+      return r;
+    }
+
+    // Usage: argv[0] <file> [<variable>...]
+    //
+    // Read the .pc file with the native reader and print the flags and the
+    // requested variables or "unsupported" if the reader cannot handle the
+    // file (or it has dependencies). Fail if the result differs from what
+    // libpkgconf produces.
+    //
+    int
+    main (int argc, char* argv[])
+    {
+      assert (argc >= 2);
+
+      path f (argv[1]);
+      f.complete ().normalize ();
+
+      optional<pkgconfig_file> r (pkgconfig_read (f));
+
+      if (!r || !r->requires.empty () || !r->requires_private.empty ())
+      {
+        cout << "unsupported" << endl;
+        return 0;
+      }
+
+      pkgconf_client_t* c (
+        call_pkgconf_client_new (&pkgconf_client_new,
+                                 error_handler,
+                                 nullptr /* handler_data */));
+
+      // Clear the system directories so that nothing is filtered out.
+      //
+      pkgconf_path_free (&c->filter_libdirs);
+      pkgconf_path_free (&c->filter_includedirs);
+      c->filter_libdirs = PKGCONF_LIST_INITIALIZER;
+      c->filter_includedirs = PKGCONF_LIST_INITIALIZER;
+
+      pkgconf_pkg_t* p (pkgconf_pkg_find (c, f.string ().c_str ()));
+      assert (p != nullptr);
+
+      bool ok (true);
+
+      auto print = [&ok] (const char* n, const strings& x, const strings& y)
+      {
+        cout << n << ':';
+        for (const string& a: x)
+          cout << ' ' << a;
+        cout << endl;
+
+        if (x != y)
+        {
+          cerr << n << " differs from libpkgconf:";
+          for (const string& a: y)
+            cerr << ' ' << a;
+          cerr << endl;
+
+          ok = false;
+        }
+      };
+
+      print ("cflags",
+             concat (r->cflags, nullptr),
+             extract (c, p, true, false));
+
+      print ("cflags.static",
+             concat (r->cflags, &r->cflags_private),
+             extract (c, p, true, true));
+
+      print ("libs",
+             concat (r->libs, nullptr),
+             extract (c, p, false, false));
+
+      print ("libs.static",
+             concat (r->libs, &r->libs_private),
+             extract (c, p, false, true));
+
+      for (int i (2); i < argc; ++i)
+      {
+        const char* n (argv[i]);
+
+        auto j (r->variables.find (n));
+        string v (j != r->variables.end () ? j->second : string ());
+
+        const char* lv (pkgconf_tuple_find (c, &p->vars, n));
+
+        cout << n << ": " << v << endl;
+
+        if (v != (lv != nullptr ? lv : ""))
+        {
+          cerr << n << " differs from libpkgconf: "
+               << (lv != nullptr ? lv : "") << endl;
+
+          ok = false;
+        }
+      }
+
+      pkgconf_pkg_unref (c, p);
+      pkgconf_client_free (c);
+
+      return ok ? 0 : 1;
+    }
+  }
+}
+
+int
+main (int argc, char* argv[])
+{
+  return build2::cc::main (argc, argv);
+}
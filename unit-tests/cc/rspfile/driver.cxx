@@ -0,0 +1,108 @@
+// file      : unit-tests/cc/rspfile/driver.cxx -*- C++ -*-
+// copyright : Copyright (c) 2014-2019 Code Synthesis Ltd
+// license   : MIT; see accompanying LICENSE file
+
+#include <cassert>
+#include <iostream>
+
+#include <build2/types.hxx>
+#include <build2/utility.hxx>
+#include <build2/filesystem.hxx>
+
+#include <build2/cc/utility.hxx>
+
+using namespace std;
+using namespace butl;
+
+namespace build2
+{
+  namespace cc
+  {
+    // Usage: argv[0] [--msvc] [--short]
+    //
+    // Read the arguments from stdin, one per line, and pass them (preceded
+    // by the program name and, unless --short is specified, by an argument
+    // that makes the command line too long) to rspfile(). Then print the
+    // response file contents with the long argument replaced with
+    // -DLONG=... or "no response file" if none was used. Fail if the
+    // resulting or the original arguments are not as expected.
+    //
+    int
+    main (int argc, char* argv[])
+    {
+      bool msvc (false);
+      bool shrt (false);
+
+      for (int i (1); i != argc; ++i)
+      {
+        string o (argv[i]);
+
+        if (o == "--msvc")
+          msvc = true;
+        else if (o == "--short")
+          shrt = true;
+        else
+          assert (false);
+      }
+
+      string lng ("-DLONG=" + string (200000, 'x'));
+
+      strings as;
+      for (string l; getline (cin, l); )
+        as.push_back (move (l));
+
+      cstrings args {"cc"};
+
+      if (!shrt)
+        args.push_back (lng.c_str ());
+
+      for (const string& a: as)
+        args.push_back (a.c_str ());
+
+      args.push_back (nullptr);
+
+      const cstrings iargs (args);
+
+      path f (path::temp_path ("rspfile"));
+      auto_rmfile rm;
+      string arg;
+      cstrings oargs;
+
+      if (!rspfile (args, 1, f, msvc, rm, arg, &oargs))
+      {
+        assert (args == iargs && oargs.empty () && arg.empty ());
+        cout << "no response file" << endl;
+        return 0;
+      }
+
+      assert (args.size () == 3                  &&
+              args[0] == iargs[0]                &&
+              arg == '@' + f.string ()           &&
+              args[1] == arg.c_str ()            &&
+              args[2] == nullptr                 &&
+              oargs == iargs);
+
+      string s;
+      {
+        ifdstream is (f);
+        s = is.read_text ();
+      }
+
+      if (!shrt)
+      {
+        size_t p (s.find (lng));
+        assert (p == 0);
+        s.replace (p, lng.size (), "-DLONG=...");
+      }
+
+      cout << s;
+      return 0;
+    }
+  }
+}
+
+int
+main (int argc, char* argv[])
+{
+  return build2::cc::main (argc, argv);
+}